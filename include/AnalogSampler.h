@@ -0,0 +1,74 @@
+#ifndef ANALOGSAMPLER_H_
+#define ANALOGSAMPLER_H_
+
+#include "API.h"
+
+#include <stdbool.h>
+
+#define ANALOG_SAMPLER_CHANNELS 8
+#define ANALOG_SAMPLER_OVERSAMPLE 4
+#define ANALOG_SAMPLER_HISTORY 4
+#define ANALOG_SAMPLER_EDGES 8
+
+/**
+ * A threshold crossing of an analog channel: time is the micros() timestamp of the sample that
+ * crossed, isLow whether the channel went below its low threshold or above its high one.
+ */
+typedef struct AnalogEdge {
+	unsigned long time;
+	bool isLow;
+} AnalogEdge;
+
+typedef struct AnalogChannel {
+	bool isEnabled;
+	int history[ANALOG_SAMPLER_HISTORY];
+	unsigned int next;
+	volatile int value;
+	int low;
+	int high;
+	volatile bool isLow;
+	bool hasThresholds;
+	AnalogEdge edges[ANALOG_SAMPLER_EDGES];
+	volatile unsigned int edgeCount;
+} AnalogChannel;
+
+/**
+ * Starts sampling analog port (1 to 8) from analogSamplerTask.
+ */
+void analogSamplerEnable(unsigned char port);
+
+/**
+ * Tracks whether the port's filtered value is low, going low below low and high again above
+ * high, and records a timestamped edge at each change. Enables the port.
+ */
+void analogSamplerSetThresholds(unsigned char port, int low, int high);
+
+/**
+ * Returns the latest filtered value of the port: the mean of its last ANALOG_SAMPLER_HISTORY
+ * samples, each the mean of ANALOG_SAMPLER_OVERSAMPLE reads. Ports that aren't enabled are read
+ * directly.
+ */
+int analogSamplerValue(unsigned char port);
+
+/**
+ * Returns the port's thresholded state as of the latest sample.
+ */
+bool analogSamplerIsLow(unsigned char port);
+
+/**
+ * Returns the number of edges the port has recorded so far.
+ */
+unsigned int analogSamplerEdgeCount(unsigned char port);
+
+/**
+ * Copies the port's edge number index, counting from 0, into edge. Returns false if that edge
+ * hasn't happened yet or has been overwritten by newer ones.
+ */
+bool analogSamplerEdge(unsigned char port, unsigned int index, AnalogEdge* edge);
+
+/**
+ * Samples every enabled port; run it every millisecond.
+ */
+void analogSamplerTask();
+
+#endif  // ANALOGSAMPLER_H_
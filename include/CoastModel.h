@@ -0,0 +1,33 @@
+#ifndef COASTMODEL_H_
+#define COASTMODEL_H_
+
+/**
+ * Predicts how far the drivetrain keeps moving once power is cut, as
+ * linear * |v| + quadratic * v^2 in the direction of v. Works for linear (in, in/s) and angular
+ * (rad, rad/s) motion alike.
+ */
+typedef struct CoastModel {
+	double linear;
+	double quadratic;
+} CoastModel;
+
+/**
+ * One coast-down measurement: the velocity when power was cut and the distance travelled until
+ * the drivetrain stopped.
+ */
+typedef struct CoastSample {
+	double velocity;
+	double distance;
+} CoastSample;
+
+CoastModel coastModelCreate(double linear, double quadratic);
+
+double coastModelStoppingDistance(const CoastModel* coastModel, double velocity);
+
+/**
+ * Least squares fit of a coast model to coast-down samples. Falls back to a purely linear model
+ * if the samples don't span enough velocities to separate the two terms.
+ */
+CoastModel coastModelFit(const CoastSample* samples, unsigned int count);
+
+#endif  // COASTMODEL_H_
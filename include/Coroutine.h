@@ -0,0 +1,103 @@
+#ifndef COROUTINE_H_
+#define COROUTINE_H_
+
+#include "API.h"
+
+#include <stdbool.h>
+
+#define COROUTINE_GROUP_SIZE 6
+
+typedef enum CoroutineStatus {
+	CoroutineRunning,
+	CoroutineDone
+} CoroutineStatus;
+
+/**
+ * State of a stackless coroutine: the line to resume at and a wake time for
+ * COROUTINE_DELAY. A zeroed Coroutine starts from the beginning.
+ */
+typedef struct Coroutine {
+	unsigned int line;
+	unsigned long wakeTime;
+} Coroutine;
+
+/**
+ * Body of a coroutine. It runs until its next wait and returns, resuming there on the following
+ * call. Locals are not kept across waits; keep state in arg or in statics. A coroutine must
+ * not call blocking functions such as delay() or the blocking Navigator moves, since they stall
+ * every track of its group; drive with the step functions like
+ * navigatorAdaptiveDriveTowardsPoint instead.
+ */
+typedef CoroutineStatus (*CoroutineFunction)(Coroutine* coroutine, void* arg);
+
+#define COROUTINE_BEGIN(coroutine) switch ((coroutine)->line) { case 0:
+
+#define COROUTINE_END(coroutine) } (coroutine)->line = 0; return CoroutineDone
+
+/**
+ * Returns until condition holds, checking it again every time the coroutine is run.
+ */
+#define COROUTINE_WAIT_UNTIL(coroutine, condition) \
+	do { \
+		(coroutine)->line = __LINE__; \
+	case __LINE__: \
+		if (!(condition)) { \
+			return CoroutineRunning; \
+		} \
+	} while (0)
+
+#define COROUTINE_YIELD(coroutine) \
+	do { \
+		(coroutine)->line = __LINE__; \
+		return CoroutineRunning; \
+	case __LINE__:; \
+	} while (0)
+
+#define COROUTINE_DELAY(coroutine, time) \
+	do { \
+		(coroutine)->wakeTime = millis() + (time); \
+		COROUTINE_WAIT_UNTIL(coroutine, (long) (millis() - (coroutine)->wakeTime) >= 0); \
+	} while (0)
+
+/**
+ * Waits for track of group, as returned by coroutineGroupSpawn, to finish.
+ */
+#define COROUTINE_AWAIT(coroutine, group, track) \
+	COROUTINE_WAIT_UNTIL(coroutine, coroutineGroupIsDone(group, track))
+
+typedef struct CoroutineTrack {
+	CoroutineFunction function;
+	void* arg;
+	Coroutine coroutine;
+	bool isDone;
+} CoroutineTrack;
+
+/**
+ * Tracks that run cooperatively in the task that runs the group.
+ */
+typedef struct CoroutineGroup {
+	CoroutineTrack tracks[COROUTINE_GROUP_SIZE];
+	unsigned int count;
+} CoroutineGroup;
+
+CoroutineGroup coroutineGroupCreate();
+
+/**
+ * Adds a track that runs function with arg from its beginning. Returns the track index, or -1
+ * if the group is full.
+ */
+int coroutineGroupSpawn(CoroutineGroup* group, CoroutineFunction function, void* arg);
+
+bool coroutineGroupIsDone(const CoroutineGroup* group, int track);
+
+/**
+ * Runs every unfinished track once and returns how many are still running.
+ */
+unsigned int coroutineGroupRun(CoroutineGroup* group);
+
+/**
+ * Runs the group every period ms until all of its tracks are done.
+ */
+void coroutineGroupJoin(CoroutineGroup* group, unsigned long period);
+
+#endif  // COROUTINE_H_
@@ -29,4 +29,24 @@ void driveSetPowerLeft(const Drive* drive, double power);
 
 void driveSetPowerRight(const Drive* drive, double power);
 
+/**
+ * Returns the largest PWM magnitude currently sent to either side of the drive.
+ */
+int driveGetPwmMax(const Drive* drive);
+
+/**
+ * Actively stops the drive: applies counter-power proportional to each side's measured wheel
+ * velocity until both sides are slower than stopVelocity, then releases the motors. Blocks until
+ * stopped or until timeout milliseconds have passed.
+ *
+ * @param drive         Drive to stop.
+ * @param odometry      Odometry supplying wheel velocities; its task must be running.
+ * @param gain          Counter-power per inch per second of wheel velocity.
+ * @param maxPower      Largest counter-power applied.
+ * @param stopVelocity  Wheel velocity, in inches per second, considered stopped.
+ * @param timeout       Maximum milliseconds to brake for.
+ */
+void driveBrake(const Drive* drive, Odometry* odometry, double gain, double maxPower,
+		double stopVelocity, unsigned long timeout);
+
 #endif  // DRIVE_H_
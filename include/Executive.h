@@ -0,0 +1,62 @@
+#ifndef EXECUTIVE_H_
+#define EXECUTIVE_H_
+
+#include "API.h"
+
+#include <stdbool.h>
+
+typedef void (*ExecutiveFunction)();
+
+/**
+ * A periodic job of the executive. It runs every period ms, offset by phase ms from when it is
+ * started, and jobs due in the same tick run in order of priority, lowest value first. A job
+ * misses its deadline when it finishes after its next release. The statistics are kept by the
+ * executive.
+ */
+typedef struct ExecutiveJob {
+	const char* name;
+	ExecutiveFunction function;
+	unsigned long period;
+	unsigned long phase;
+	unsigned char priority;
+	volatile bool isEnabled;
+	unsigned long nextRelease;
+	unsigned long runs;
+	unsigned long long totalMicros;
+	unsigned long maxMicros;
+	unsigned long misses;
+} ExecutiveJob;
+
+/**
+ * Runs a static table of jobs from a single task that wakes every millisecond, in place of one
+ * taskRunLoop task per job.
+ */
+typedef struct Executive {
+	ExecutiveJob* jobs;
+	unsigned int count;
+	TaskHandle task;
+} Executive;
+
+Executive executiveCreate(ExecutiveJob* jobs, unsigned int count);
+
+/**
+ * Starts the executive's task unless it is already running.
+ */
+void executiveStart(Executive* executive);
+
+/**
+ * Enables job, first released phase ms from now. A period of 0 keeps the job's period. Calling
+ * it for a running job with the same period leaves it alone, so mode entry can call it every
+ * time.
+ */
+void executiveEnable(Executive* executive, unsigned int job, unsigned long period);
+
+void executiveDisable(Executive* executive, unsigned int job);
+
+/**
+ * Prints one "job," CSV line per job with its runs, mean and worst runtime in us and deadline
+ * misses.
+ */
+void executivePrintStats(const Executive* executive, PROS_FILE* stream);
+
+#endif  // EXECUTIVE_H_
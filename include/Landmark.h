@@ -0,0 +1,71 @@
+#ifndef LANDMARK_H_
+#define LANDMARK_H_
+
+#include "API.h"
+#include "Odometry.h"
+#include "Pose.h"
+
+#include <stdbool.h>
+
+typedef enum LandmarkType {
+	LandmarkLine,
+	LandmarkBar,
+} LandmarkType;
+
+/**
+ * A straight field feature from start to end, in the odometry frame, width inches across. Only
+ * the x and y of the poses are used.
+ */
+typedef struct Landmark {
+	LandmarkType type;
+	Pose start;
+	Pose end;
+	double width;
+} Landmark;
+
+/**
+ * A sensor on analog port that sees landmarks of type, mounted x inches forward and y inches
+ * left of the robot's center. It sees a line when its reading goes low and a bar when it goes
+ * high; nextEdge is the index of the next analog sampler edge to look at.
+ */
+typedef struct LandmarkSensor {
+	unsigned char port;
+	LandmarkType type;
+	double x;
+	double y;
+	unsigned int nextEdge;
+} LandmarkSensor;
+
+/**
+ * Corrects odometry when a sensor sees a landmark. The pose at the time of the edge places the
+ * sensor on the field; the nearest landmark of the sensor's type within matchDistance inches
+ * of it is taken as the one seen. The sensor is over the landmark's near edge, half its width
+ * from the middle on the side the sensor came from. Only the offset across the landmark is
+ * observable, so the pose is shifted along the landmark's normal by gain times the sensor's
+ * offset from that edge, at most maxCorrection inches. Edges without a match are counted as
+ * rejections and change nothing; edges newer than the latest pose wait for the next update.
+ */
+typedef struct LandmarkCorrector {
+	Odometry* odometry;
+	const Landmark* landmarks;
+	unsigned int landmarkCount;
+	LandmarkSensor* sensors;
+	unsigned int sensorCount;
+	double matchDistance;
+	double maxCorrection;
+	double gain;
+	unsigned int corrections;
+	unsigned int rejections;
+} LandmarkCorrector;
+
+LandmarkCorrector landmarkCorrectorCreate(Odometry* odometry, const Landmark* landmarks,
+		unsigned int landmarkCount, LandmarkSensor* sensors, unsigned int sensorCount,
+		double matchDistance, double maxCorrection, double gain);
+
+/**
+ * Handles the sensors' new edges. Run it periodically, within the odometry history of the
+ * edges.
+ */
+void landmarkCorrectorUpdate(LandmarkCorrector* corrector);
+
+#endif  // LANDMARK_H_
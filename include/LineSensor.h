@@ -3,13 +3,25 @@
 
 #include "API.h"
 
+#define LINE_SENSOR_HYSTERESIS 50
+
 typedef struct LineSensor {
   int toggle_level;
   unsigned char port;
 } LineSensor;
 
+/**
+ * Creates a line sensor sampled in the background by the analog sampler. It sees a line once
+ * its reading drops below toggle - LINE_SENSOR_HYSTERESIS and stops seeing it above toggle +
+ * LINE_SENSOR_HYSTERESIS.
+ */
 LineSensor lineSensorCreate(unsigned char port, int toggle);
 
+/**
+ * Returns the latest filtered reading of the sensor without reading the port.
+ */
+int lineSensorValue(const LineSensor* lineSensor);
+
 int lineSensorHasLine(const LineSensor* lineSensor);
 
 #endif
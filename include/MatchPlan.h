@@ -0,0 +1,77 @@
+#ifndef MATCHPLAN_H_
+#define MATCHPLAN_H_
+
+#include "API.h"
+
+#include <stdbool.h>
+
+#define MATCH_AUTONOMOUS_TIME 15000
+#define MATCH_SKILLS_TIME 60000
+// Pending steps planned at a time; the search tries 3^MATCH_PLAN_SEARCH_STEPS combinations.
+#define MATCH_PLAN_SEARCH_STEPS 6
+
+typedef void (*MatchStepFunction)(double arg);
+
+typedef enum MatchStepStatus {
+	MatchStepPending,
+	MatchStepRan,
+	MatchStepRanShort,
+	MatchStepSkipped
+} MatchStepStatus;
+
+/**
+ * One step of a match plan. estimate is the expected duration in ms and value the points it
+ * scores. A step may have a short variant, runShort, that is expected to take shortEstimate ms
+ * and score shortValue; without one runShort is NULL. Consecutive movable steps don't depend on
+ * each other's end positions, so they may run in any order. status, planned and duration are
+ * filled in by the plan.
+ */
+typedef struct MatchStep {
+	const char* name;
+	MatchStepFunction run;
+	MatchStepFunction runShort;
+	double arg;
+	unsigned long estimate;
+	unsigned long shortEstimate;
+	double value;
+	double shortValue;
+	bool isMovable;
+	MatchStepStatus status;
+	MatchStepStatus planned;
+	unsigned long duration;
+} MatchStep;
+
+/**
+ * Runs steps against the match clock. Before each step the next MATCH_PLAN_SEARCH_STEPS pending
+ * steps are planned to fit the time left: each runs in full, runs short or is skipped, whichever
+ * combination scores the most value within the estimates. A step that isn't movable is only
+ * skipped along with every step after it. Among movable steps the one with the highest planned
+ * value runs first.
+ */
+typedef struct MatchPlan {
+	MatchStep* steps;
+	unsigned int count;
+	unsigned long budget;
+	unsigned long startTime;
+} MatchPlan;
+
+MatchPlan matchPlanCreate(MatchStep* steps, unsigned int count, unsigned long budget);
+
+/**
+ * Starts the match clock. Call as the match period starts, before any setup that counts
+ * against the time.
+ */
+void matchPlanStart(MatchPlan* matchPlan);
+
+/**
+ * Returns the ms left in the budget, or 0 once it has run out.
+ */
+unsigned long matchPlanRemaining(const MatchPlan* matchPlan);
+
+/**
+ * Runs the plan to completion and prints one "match," CSV line per step with its estimate,
+ * actual duration and status.
+ */
+void matchPlanRun(MatchPlan* matchPlan);
+
+#endif  // MATCHPLAN_H_
@@ -14,6 +14,11 @@ void motorSetPwm(const Motor* motor, int pwm);
 
 void motorSetPower(const Motor* motor, double power);
 
+/**
+ * Returns the PWM value last sent to the motor, in the motor's own direction.
+ */
+int motorGetPwm(const Motor* motor);
+
 /**
  * Converts from output power to PWM value, in order to linearize motor output.
  *
@@ -0,0 +1,77 @@
+#ifndef MOVELOG_H_
+#define MOVELOG_H_
+
+#include "API.h"
+
+#define MOVE_LOG_SIZE 64
+
+typedef enum MoveType {
+	MoveDriveToDistance,
+	MoveTurnToAngle,
+	MoveArc,
+	MoveAdaptiveDrive,
+	MoveAdaptiveTurn,
+	MoveTrajectory,
+	MoveSegments,
+	MoveDriveToPose,
+} MoveType;
+
+typedef enum MoveStatus {
+	MoveSettled,
+	MoveHandedOff,
+	MoveStopped,
+	MoveCompleted,
+	MoveStalled,
+	MoveTimedOut,
+} MoveStatus;
+
+/**
+ * Summary of one Navigator move. Times are millis() timestamps; thresholdTime is 0 if the error
+ * never got inside the done threshold. Overshoot is the largest error past the target, in
+ * inches or radians.
+ */
+typedef struct MoveRecord {
+	const char* routine;
+	unsigned char leg;
+	unsigned char type;
+	unsigned char status;
+	unsigned long startTime;
+	unsigned long thresholdTime;
+	unsigned long endTime;
+	float overshoot;
+	float finalError;
+} MoveRecord;
+
+typedef struct MoveLog {
+	MoveRecord records[MOVE_LOG_SIZE];
+	unsigned int next;
+	unsigned int count;
+	const char* routine;
+	unsigned char leg;
+} MoveLog;
+
+void moveLogClear(MoveLog* moveLog);
+
+/**
+ * Labels the following moves with routine and restarts the leg count, so moves can be traced
+ * back to the routine that issued them.
+ */
+void moveLogSetRoutine(MoveLog* moveLog, const char* routine);
+
+/**
+ * Stores a record, overwriting the oldest one once the log is full. The routine and leg are
+ * filled in from the log.
+ */
+void moveLogAdd(MoveLog* moveLog, MoveRecord record);
+
+/**
+ * Prints every record, oldest first, as CSV lines prefixed with "move," so they can be picked
+ * out of other serial output by tools/movelog_summary.py.
+ */
+void moveLogDump(const MoveLog* moveLog, PROS_FILE* stream);
+
+const char* moveTypeName(MoveType type);
+
+const char* moveStatusName(MoveStatus status);
+
+#endif  // MOVELOG_H_
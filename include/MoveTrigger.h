@@ -0,0 +1,54 @@
+#ifndef MOVETRIGGER_H_
+#define MOVETRIGGER_H_
+
+#include "API.h"
+#include "Pose.h"
+
+#include <stdbool.h>
+
+typedef void (*MoveTriggerAction)();
+
+typedef enum MoveTriggerType {
+	MoveTriggerDistance,
+	MoveTriggerFraction,
+	MoveTriggerRegion,
+	MoveTriggerTime,
+} MoveTriggerType;
+
+/**
+ * An action fired once during a move, as soon as the move has travelled value inches in either
+ * direction, completed value of its starting error (0 to 1), entered the circle of radius
+ * inches around center, or run for value ms. A trigger that isn't due by the time the move ends,
+ * because it stopped, stalled, timed out or settled short, fires when it ends.
+ */
+typedef struct MoveTrigger {
+	MoveTriggerType type;
+	double value;
+	Pose center;
+	double radius;
+	MoveTriggerAction action;
+	bool hasFired;
+} MoveTrigger;
+
+MoveTrigger moveTriggerDistance(double distance, MoveTriggerAction action);
+
+MoveTrigger moveTriggerFraction(double fraction, MoveTriggerAction action);
+
+MoveTrigger moveTriggerRegion(Pose center, double radius, MoveTriggerAction action);
+
+MoveTrigger moveTriggerTime(unsigned long time, MoveTriggerAction action);
+
+/**
+ * Fires every trigger that hasn't fired yet and is due. travelled is in inches since the move
+ * started, fraction the share of the starting error that is done and elapsed the ms since the
+ * move started.
+ */
+void moveTriggersUpdate(MoveTrigger* triggers, unsigned int count, double travelled,
+		double fraction, Pose pose, unsigned long elapsed);
+
+/**
+ * Fires every trigger that hasn't fired yet, for a move that ended before they were due.
+ */
+void moveTriggersFinish(MoveTrigger* triggers, unsigned int count);
+
+#endif  // MOVETRIGGER_H_
@@ -1,12 +1,18 @@
 #ifndef NAVIGATOR_H_
 #define NAVIGATOR_H_
 
+#include "CoastModel.h"
 #include "Drive.h"
 #include "Odometry.h"
 #include "PidController.h"
 #include "Pose.h"
+#include "RamseteController.h"
+#include "Trajectory.h"
+#include "StopCondition.h"
 #include "Vector.h"
 #include "LineSensor.h"
+#include "MoveLog.h"
+#include "MoveTrigger.h"
 
 #include <stdbool.h>
 
@@ -20,8 +26,29 @@
 #define UNTIL_RIGHT_BAR 0x80
 #define UNTIL_MOGO_FOUND 0x100
 
-#define SMOOTH_TURN_LEFT -1
-#define SMOOTH_TURN_RIGHT 1
+#define NAVIGATOR_MAX_UNTIL_CONDITIONS 8
+
+typedef enum NavigatorSegmentType {
+	NavigatorSegmentDrive,
+	NavigatorSegmentTurn,
+} NavigatorSegmentType;
+
+typedef enum NavigatorDirection {
+	NavigatorDirectionAuto,
+	NavigatorDirectionForward,
+	NavigatorDirectionReverse
+} NavigatorDirection;
+
+/**
+ * One leg of a chained move. Drive segments travel distance inches while holding angle, turn
+ * segments turn in place to angle. maxPower bounds the power used during the segment.
+ */
+typedef struct NavigatorSegment {
+	NavigatorSegmentType type;
+	double distance;
+	double angle;
+	double maxPower;
+} NavigatorSegment;
 
 typedef struct Navigator {
 	Drive* drive;
@@ -29,6 +56,12 @@ typedef struct Navigator {
 	PidController driveController;
 	PidController straightController;
 	PidController turnController;
+	bool useYawRate;
+	RamseteController ramseteController;
+	double maxVelocity;
+	double blendDistance;
+	double maxPowerStep;
+	double drivePower;
 	double deadReckonRadius;
 	double driveDoneThreshold;
 	double turnDoneThreshold;
@@ -38,41 +71,154 @@ typedef struct Navigator {
 	Vector deadReckonVector;
 	unsigned long timestamp;
 	double until_target;
+	unsigned int controlDivider;
+	unsigned long lastSample;
+	StopCondition* stopConditions;
+	unsigned int stopConditionCount;
+	int stoppedBy;
+	MoveLog* moveLog;
+	MoveRecord move;
+	double moveStartError;
+	unsigned int moveDepth;
+	MoveStatus moveStatus;
+	// A move ends as MoveStalled once the drive is commanded at least stallPower while both wheels
+	// stay under stallVelocity (in/s) for stallTime ms. A stallTime of 0 disables it.
+	double stallPower;
+	double stallVelocity;
+	unsigned long stallTime;
+	unsigned long stallTimestamp;
+	// Milliseconds after which the next move ends as MoveTimedOut; 0 for none. Cleared when
+	// that move ends.
+	unsigned long moveTimeout;
+	// A move with zero endPower is settled once |error| is inside its done threshold and the
+	// velocity (in/s, or rad/s for turns) is under the settle velocity. It ends early, with power
+	// cut, once the coast model predicts coasting into the threshold, and brakes with
+	// coastBrakePower while it predicts coasting past it. A zero coast model disables both.
+	double driveSettleVelocity;
+	double turnSettleVelocity;
+	CoastModel driveCoast;
+	CoastModel turnCoast;
+	double coastBrakePower;
+	// When set, the next move that doesn't hand off finishes with driveBrake instead of coasting.
+	// Cleared when that move ends.
+	bool brakeOnExit;
+	double brakeGain;
+	double brakeMaxPower;
+	double boomerangLead;
+	double arcOffsetGain;
+	// Side that leads the next point move; cleared back to NavigatorDirectionForward when that
+	// move ends, so Auto is opt-in per move. Auto picks whichever side reaches the point sooner,
+	// estimating pivots at turnRate (rad/s) and charging reversePenalty ms for leading with the
+	// back. A negative maxPower still forces reverse. The endPower of navigatorDriveToPoint and
+	// navigatorDriveToPose is along the chosen direction of travel, so a negative endPower brakes
+	// whichever side leads.
+	NavigatorDirection direction;
+	double turnRate;
+	unsigned long reversePenalty;
+	MoveTrigger* triggers;
+	unsigned int triggerCount;
+	double moveStartDistance;
 } Navigator;
 
 Navigator navigatorCreate(Drive* drive, Odometry* odometry, PidController driveController,
 		PidController straightController, PidController turnController, double deadReckonRadius,
 		double driveDoneThreshold, double turnDoneThreshold, unsigned long doneTime);
 
+/**
+ * Makes every following move end early once any of the stop conditions trips, until the
+ * conditions are cleared. navigator->stoppedBy holds the index of the condition that tripped, or
+ * -1. The array must stay valid while it is set. The *Until moves run with their own conditions
+ * in place of these and set them again afterwards; stoppedBy then indexes the until conditions,
+ * in UNTIL_* bit order.
+ */
+void navigatorSetStopConditions(Navigator* navigator, StopCondition* stopConditions,
+		unsigned int count);
+
+void navigatorClearStopConditions(Navigator* navigator);
+
+/**
+ * Fires the triggers' actions during the next move, from its control loop. Distances are
+ * measured along the wheels from the start of the move; fractions compare the error with the
+ * error the move started with, so use distances for navigatorDriveSegments. Triggers that haven't
+ * fired when that move ends, however it ends, fire then and are dropped; the array must stay
+ * valid until then.
+ */
+void navigatorSetTriggers(Navigator* navigator, MoveTrigger* triggers, unsigned int count);
+
 void navigatorDriveAtAngle(Navigator* navigator, double angle, double power);
 
 bool navigatorTurnTowardsPoint(Navigator* navigator, Pose point, double maxPower, double endPower);
 void navigatorDriveForTime(Navigator* navigator, double leftPower, double rightPower, double time);
 
-void navigatorDriveToDistance(Navigator* navigator, double distance, double angle, double maxPower, double endPower);
+MoveStatus navigatorDriveToDistance(Navigator* navigator, double distance, double angle, double maxPower, double endPower);
 
-void navigatorTurnToAngle(Navigator* navigator, double angle, double maxPower, double endPower) ;
+MoveStatus navigatorTurnToAngle(Navigator* navigator, double angle, double maxPower, double endPower) ;
 
-void navigatorDriveToDistanceUntil(Navigator* navigator, double distance, double angle, double maxPower, double endPower, int until);
+MoveStatus navigatorDriveToDistanceUntil(Navigator* navigator, double distance, double angle, double maxPower, double endPower, int until);
 
-void navigatorSmoothTurnToAngle(Navigator* navigator, double dir, double angle, double maxPower, double deadPower, double endPower);
+/**
+ * Drives a constant-curvature arc of the given radius (inches) that turns the heading by sweep
+ * radians, positive counterclockwise. The move ends on distance: once the wheels have averaged
+ * the arc length, radius times |sweep|, like navigatorDriveToDistance. Wheel powers are split in the ratio the arc needs and
+ * corrected with the straight controller from both the heading error against the arc and the
+ * distance off the arc (scaled by arcOffsetGain, radians per inch). A negative maxPower drives
+ * the arc backwards.
+ */
+MoveStatus navigatorArc(Navigator* navigator, double radius, double sweep, double maxPower,
+		double endPower);
 
-void navigatorTurnToAngle(Navigator* navigator, double angle, double maxPower, double endPower);
+MoveStatus navigatorTurnToAngle(Navigator* navigator, double angle, double maxPower, double endPower);
 
-void navigatorDriveToPoint(Navigator* navigator, Pose point, double maxPower, double endPower);
+MoveStatus navigatorDriveToPoint(Navigator* navigator, Pose point, double maxPower, double endPower);
 
-void navigatorTurnToPoint(Navigator* navigator, Pose point, double maxPower, double endPower);
+MoveStatus navigatorTurnToPoint(Navigator* navigator, Pose point, double maxPower, double endPower);
 
-void navigatorDriveToPointUntil(Navigator* navigator, Pose point, double maxPower, double endPower, int until);
+MoveStatus navigatorDriveToPointUntil(Navigator* navigator, Pose point, double maxPower, double endPower, int until);
 
 bool navigatorAdaptiveDriveTowardsPoint(Navigator* navigator, Pose point, double maxPower, double endPower);
 
 bool navigatorAdaptiveTurnTowardsPoint(Navigator* navigator, Pose point, double maxPower, double endPower);
 
-void navigatorAdaptiveDriveToPoint(Navigator* navigator, Pose point, double maxPower, double endPower);
-
-void navigatorAdaptiveTurnToPoint(Navigator* navigator, Pose point, double maxPower, double endPower);
-
-void navigatorAdaptiveDriveToPointUntil(Navigator* navigator, Pose point, double maxPower, double endPower, int until);
+MoveStatus navigatorAdaptiveDriveToPoint(Navigator* navigator, Pose point, double maxPower, double endPower);
+
+MoveStatus navigatorAdaptiveTurnToPoint(Navigator* navigator, Pose point, double maxPower, double endPower);
+
+MoveStatus navigatorAdaptiveDriveToPointUntil(Navigator* navigator, Pose point, double maxPower, double endPower, int until);
+
+/**
+ * Tracks a time-indexed reference with the Ramsete controller, starting the trajectory clock on
+ * entry. Wheel velocities are converted to power by dividing by navigator->maxVelocity.
+ */
+MoveStatus navigatorFollowTrajectory(Navigator* navigator, const Trajectory* trajectory, double endPower);
+
+/**
+ * Runs segments back to back without stopping between them. Each drive segment exits at a power
+ * planned from the next segment's max power and heading change, blending its heading into the
+ * next segment's over navigator->blendDistance inches. Power changes are slew limited to
+ * navigator->maxPowerStep per loop, starting from the measured chassis velocity. The last
+ * segment finishes like navigatorDriveToDistance and navigatorTurnToAngle with endPower. A segment
+ * that ends any other way than settled or handed off ends the chain with endPower and its
+ * status.
+ */
+MoveStatus navigatorDriveSegments(Navigator* navigator, const NavigatorSegment* segments,
+		unsigned int count, double endPower);
+
+/**
+ * Drives to target and arrives facing target.theta in one curved move. Steers at a carrot point
+ * placed boomerangLead times the remaining distance behind the target along its heading, so the
+ * path curves into the final heading; inside deadReckonRadius it steers to target.theta directly.
+ * The move ends on distance, like navigatorDriveToPoint. A negative maxPower backs into the pose.
+ */
+MoveStatus navigatorDriveToPose(Navigator* navigator, Pose target, double maxPower,
+		double endPower);
+
+/**
+ * Runs one coast-down test for identifying navigator->driveCoast or navigator->turnCoast: drives
+ * (or turns in place) at power for time ms, cuts power and measures how far the drivetrain
+ * coasts. The sample is also printed over serial as "coast,drive|turn,velocity,distance". Fit
+ * several samples at different powers with coastModelFit.
+ */
+CoastSample navigatorMeasureCoast(Navigator* navigator, bool isTurn, double power,
+		unsigned long time);
 
 #endif  // NAVIGATOR_H_
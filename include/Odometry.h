@@ -6,8 +6,19 @@
 #include "Pose.h"
 #include "xsens.h"
 
+#include <stdbool.h>
+
+#define ODOMETRY_HISTORY 64
+
+typedef struct OdometrySample {
+	unsigned long time;
+	Pose pose;
+} OdometrySample;
+
 typedef struct Odometry {
 	Mutex mutex;
+	Semaphore sampleSemaphore;
+	volatile unsigned long sampleCount;
 	EncoderWheel* encoderWheelL;
 	EncoderWheel* encoderWheelR;
 	EncoderWheel* encoderWheelM;
@@ -17,7 +28,14 @@ typedef struct Odometry {
 	double lastL;
 	double lastR;
 	double lastM;
+	unsigned long lastTime;
+	double velocityL;
+	double velocityR;
 	bool useXsensNext;
+	// The last ODOMETRY_HISTORY poses with their micros() timestamps, indexed by sample count.
+	// Samples before historyStart, the sample count at the last odometrySetPose, are stale.
+	OdometrySample history[ODOMETRY_HISTORY];
+	unsigned long historyStart;
 } Odometry;
 
 Odometry odometryCreate(EncoderWheel* encoderWheelL, EncoderWheel* encoderWheelR,
@@ -31,6 +49,57 @@ Pose odometryPose(const Odometry* odometry);
 
 void odometrySetPose(Odometry* odometry, Pose pose);
 
+/**
+ * Looks up the pose at a past micros() timestamp, interpolating between the recorded poses.
+ * Returns false if time is older than the history, before the last odometrySetPose, or newer
+ * than the latest pose.
+ */
+bool odometryPoseAt(Odometry* odometry, unsigned long time, Pose* pose);
+
+/**
+ * Returns true once a pose at or after the micros() timestamp time has been recorded since the
+ * last odometrySetPose.
+ */
+bool odometryHasReached(Odometry* odometry, unsigned long time);
+
+/**
+ * Moves the current pose and the recorded history by (dx, dy) inches, keeping the heading.
+ */
+void odometryShiftPose(Odometry* odometry, double dx, double dy);
+
+/**
+ * Returns the low-pass filtered forward velocity of the chassis, in inches per second, as
+ * measured by the left and right encoder wheels.
+ */
+double odometryVelocity(const Odometry* odometry);
+
+/**
+ * Returns the chassis yaw rate, in radians per second counterclockwise. Uses the Xsens rate of
+ * turn (bias corrected) when available, otherwise the difference of the wheel velocities.
+ */
+double odometryYawRate(const Odometry* odometry);
+
+/**
+ * Returns the number of poses published by odometryComputePose so far.
+ */
+unsigned long odometrySampleCount(const Odometry* odometry);
+
+/**
+ * Blocks until n poses past *lastSample have been published, then advances *lastSample by n, so
+ * that a caller waiting in a loop stays phase locked to the odometry task the same way
+ * taskDelayUntil stays locked to the tick. If the caller has fallen n or more samples behind,
+ * *lastSample is resynchronized to the newest sample instead of bursting through the backlog.
+ * Only one task should wait on a given Odometry.
+ *
+ * @param odometry    Odometry to wait on.
+ * @param lastSample  Sample count of the previous wake up, updated on return.
+ * @param n           Number of samples per wake up.
+ * @param timeout     Maximum milliseconds to wait.
+ * @return            True if the samples arrived, false if the timeout elapsed first.
+ */
+bool odometryWaitForSamples(Odometry* odometry, unsigned long* lastSample, unsigned int n,
+		unsigned long timeout);
+
 void odometryUseXsens(Odometry* odometry);
 
 #endif  // ODOMETRY_H_
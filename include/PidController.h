@@ -15,6 +15,18 @@ PidController pidControllerCreate(double Kp, double Ki, double Kd);
 
 double pidControllerComputeOutput(PidController* pidController, double error, unsigned long t);
 
+/**
+ * Computes the output using a measured rate of the process variable for the derivative term
+ * instead of differencing the error. With a constant setpoint the error changes at -rate, so Kd
+ * keeps the same meaning as in pidControllerComputeOutput.
+ *
+ * @param error  Setpoint minus process variable.
+ * @param rate   Measured rate of change of the process variable, per second.
+ * @param t      Timestamp in microseconds.
+ */
+double pidControllerComputeOutputWithRate(PidController* pidController, double error, double rate,
+		unsigned long t);
+
 double pidControllerOutput(const PidController* pidController);
 
 #endif  // PIDCONTROLLER_H_
@@ -0,0 +1,32 @@
+#ifndef RAMSETECONTROLLER_H_
+#define RAMSETECONTROLLER_H_
+
+#include "Pose.h"
+#include "Trajectory.h"
+
+/**
+ * Nonlinear unicycle tracking controller. b (rad^2 / in^2) sets how aggressively position error
+ * is converted into turning, zeta (unitless, 0 to 1) sets the damping of the response.
+ */
+typedef struct RamseteController {
+	double b;
+	double zeta;
+	double velocity;
+	double angularVelocity;
+} RamseteController;
+
+RamseteController ramseteControllerCreate(double b, double zeta);
+
+/**
+ * Computes the chassis velocity and angular velocity that drive the pose towards the reference.
+ * Results are stored in the controller and can be read with ramseteControllerVelocity and
+ * ramseteControllerAngularVelocity.
+ */
+void ramseteControllerComputeOutput(RamseteController* ramseteController, Pose pose,
+		TrajectoryPoint reference);
+
+double ramseteControllerVelocity(const RamseteController* ramseteController);
+
+double ramseteControllerAngularVelocity(const RamseteController* ramseteController);
+
+#endif  // RAMSETECONTROLLER_H_
@@ -0,0 +1,75 @@
+#ifndef ROUTINE_H_
+#define ROUTINE_H_
+
+#include "API.h"
+#include "Navigator.h"
+#include "PidController.h"
+
+#include <stdbool.h>
+
+#define ROUTINE_MAX_LENGTH 1024
+#define ROUTINE_VERSION 1
+
+// Fixed point scales of the routine arguments, which are little-endian signed 16 bit words.
+#define ROUTINE_DISTANCE_SCALE 100.0
+#define ROUTINE_ANGLE_SCALE 100.0
+#define ROUTINE_POWER_SCALE 1000.0
+
+/**
+ * Routine opcodes. Each is one byte followed by its arguments. Distances are in hundredths of an
+ * inch, angles in hundredths of a degree, powers in thousandths and times in ms. Angles of moves
+ * have the current heading offset added. The values are part of the file format; only add new
+ * opcodes at the end.
+ */
+typedef enum RoutineOp {
+	RoutineOpEnd,
+	RoutineOpDrive,           // distance, angle, maxPower, endPower
+	RoutineOpDriveUntil,      // distance, angle, maxPower, endPower, UNTIL_* mask
+	RoutineOpTurn,            // angle, maxPower, endPower
+	RoutineOpDriveToPoint,    // x, y, maxPower, endPower
+	RoutineOpTurnToPoint,     // x, y, maxPower, endPower
+	RoutineOpDriveForTime,    // leftPower, rightPower, time
+	RoutineOpWait,            // time
+	RoutineOpUntilTarget,     // navigator until_target
+	RoutineOpTurnController,  // index into the turn controllers given to routineRun
+	RoutineOpOffset,          // heading offset angle
+	RoutineOpMogo,            // MogoState
+	RoutineOpLift,            // LiftState
+	RoutineOpIntake,          // IntakeState
+	RoutineOpWaitMogo,
+	RoutineOpWaitLift,
+	RoutineOpDigital,         // port, value
+	RoutineOpCount
+} RoutineOp;
+
+/**
+ * An autonomous routine in the binary format written by tools/routine_asm.py. Files start with
+ * the bytes 'R', 'T', ROUTINE_VERSION, 0 and the little-endian length of the code that follows.
+ */
+typedef struct Routine {
+	unsigned char code[ROUTINE_MAX_LENGTH];
+	unsigned int length;
+} Routine;
+
+/**
+ * Loads and checks a routine from the flash file system. Returns false, leaving the routine
+ * empty, if the file is missing or malformed.
+ */
+bool routineLoad(Routine* routine, const char* file);
+
+/**
+ * Reads a routine from stream, for example stdin as sent by tools/routine_asm.py, checks it and
+ * saves it to file so it is loaded by later runs. Gives up if the whole routine hasn't arrived
+ * within timeout ms. Only call with the actuators stopped.
+ */
+bool routineReceive(Routine* routine, PROS_FILE* stream, const char* file,
+		unsigned long timeout);
+
+/**
+ * Runs the routine with the navigator, starting with a heading offset in degrees. Turn
+ * controller opcodes select from turnControllers. Returns when the routine ends.
+ */
+void routineRun(const Routine* routine, Navigator* navigator, double offset,
+		const PidController* turnControllers, unsigned int turnControllerCount);
+
+#endif  // ROUTINE_H_
@@ -0,0 +1,65 @@
+#ifndef SONARSAMPLER_H_
+#define SONARSAMPLER_H_
+
+#include "API.h"
+
+#include <stdbool.h>
+
+#define SONAR_SAMPLER_CHANNELS 2
+// Each sonar pings in its own slot of this many ms, long enough for the echo to die out before
+// the next one pings.
+#define SONAR_SAMPLER_SLOT 25
+#define SONAR_SAMPLER_HISTORY 5
+// Readings further than this many cm from the median are flagged as outliers.
+#define SONAR_SAMPLER_OUTLIER 15
+// Distances are dropped once the last echo is this many ms old.
+#define SONAR_SAMPLER_STALE 150
+
+/**
+ * One ping of a sonar: time is the micros() timestamp of the ping, raw the echo distance in cm
+ * or -1 if no echo came back within the slot, distance the median of the last
+ * SONAR_SAMPLER_HISTORY echoes, and isOutlier whether raw is far from that median.
+ */
+typedef struct SonarReading {
+	unsigned long time;
+	int raw;
+	int distance;
+	bool isOutlier;
+} SonarReading;
+
+typedef struct SonarChannel {
+	unsigned char echoPort;
+	unsigned char pingPort;
+	volatile unsigned long echoStart;
+	volatile unsigned long echoEnd;
+	volatile bool isEchoDone;
+	int history[SONAR_SAMPLER_HISTORY];
+	unsigned int historyCount;
+	unsigned long echoTime;
+	SonarReading reading;
+	volatile unsigned int readingCount;
+} SonarChannel;
+
+/**
+ * Takes over the sonar with echo on digital port echoPort and ping on pingPort, in place of
+ * ultrasonicInit. Returns its index for the other functions, or -1 if there is no room.
+ */
+int sonarSamplerAdd(unsigned char echoPort, unsigned char pingPort);
+
+/**
+ * Returns the sonar's median filtered distance in cm, or -1 if it hasn't had an echo recently.
+ */
+int sonarSamplerDistance(int sonar);
+
+/**
+ * Copies the sonar's latest reading into reading. Returns false if it hasn't pinged yet.
+ */
+bool sonarSamplerReading(int sonar, SonarReading* reading);
+
+/**
+ * Finishes the current sonar's ping and pings the next one, so only one sonar listens at a
+ * time; run it every SONAR_SAMPLER_SLOT ms.
+ */
+void sonarSamplerTask();
+
+#endif  // SONARSAMPLER_H_
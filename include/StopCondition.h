@@ -0,0 +1,67 @@
+#ifndef STOPCONDITION_H_
+#define STOPCONDITION_H_
+
+#include "API.h"
+#include "LineSensor.h"
+
+#include <stdbool.h>
+
+/**
+ * Reads the raw value of a condition's sensor. Negative values are treated as invalid samples
+ * and leave the condition's state untouched.
+ */
+typedef int (*StopConditionRead)(const void* source);
+
+/**
+ * A debounced predicate that trips once the sensor value has been inside [low, high] for
+ * debounce consecutive samples. Once the value is inside the band it has to leave the band by
+ * more than hysteresis to reset the count. The sensor is read at most once every samplePeriod
+ * milliseconds; between reads the cached value is reused.
+ */
+typedef struct StopCondition {
+	StopConditionRead read;
+	const void* source;
+	int low;
+	int high;
+	int hysteresis;
+	unsigned long samplePeriod;
+	unsigned int debounce;
+	int value;
+	unsigned long sampleTime;
+	unsigned int count;
+	bool isInside;
+} StopCondition;
+
+StopCondition stopConditionCreate(StopConditionRead read, const void* source, int low, int high,
+		int hysteresis, unsigned long samplePeriod, unsigned int debounce);
+
+/**
+ * Trips when the line sensor sees a line (reading below its toggle level). A reading that has
+ * dropped below it keeps counting until it rises LINE_SENSOR_HYSTERESIS past it.
+ */
+StopCondition stopConditionLine(const LineSensor* lineSensor, unsigned int debounce);
+
+/**
+ * Trips when the line sensor stops seeing a line (reading at or above its toggle level). A
+ * reading that has risen to it keeps counting until it drops LINE_SENSOR_HYSTERESIS below it.
+ */
+StopCondition stopConditionNoLine(const LineSensor* lineSensor, unsigned int debounce);
+
+/**
+ * Trips when the SonarSampler sonar's filtered distance is between low and high, inclusive.
+ */
+StopCondition stopConditionSonar(const int* sonar, int low, int high, unsigned int debounce);
+
+void stopConditionReset(StopCondition* stopCondition);
+
+/**
+ * Samples every condition that is due and returns the index of the first condition that has
+ * tripped, or -1 if none have.
+ */
+int stopConditionsUpdate(StopCondition* stopConditions, unsigned int count, unsigned long now);
+
+int stopConditionReadAnalog(const void* lineSensor);
+
+int stopConditionReadSonar(const void* sonar);
+
+#endif  // STOPCONDITION_H_
@@ -0,0 +1,36 @@
+#ifndef TRAJECTORY_H_
+#define TRAJECTORY_H_
+
+#include "Pose.h"
+
+/**
+ * A single time-indexed reference state. Velocities are in inches per second and radians per
+ * second, time is in milliseconds from the start of the trajectory.
+ */
+typedef struct TrajectoryPoint {
+	unsigned long time;
+	Pose pose;
+	double velocity;
+	double angularVelocity;
+} TrajectoryPoint;
+
+typedef struct Trajectory {
+	const TrajectoryPoint* points;
+	unsigned int length;
+} Trajectory;
+
+Trajectory trajectoryCreate(const TrajectoryPoint* points, unsigned int length);
+
+unsigned long trajectoryDuration(const Trajectory* trajectory);
+
+/**
+ * Samples the trajectory at the given time, linearly interpolating between the surrounding
+ * points. Times before the first point or after the last point are clamped to the ends.
+ *
+ * @param trajectory  Trajectory to sample.
+ * @param time        Milliseconds since the start of the trajectory.
+ * @return            Interpolated reference state.
+ */
+TrajectoryPoint trajectorySample(const Trajectory* trajectory, unsigned long time);
+
+#endif  // TRAJECTORY_H_
@@ -5,10 +5,13 @@
 #include "Drive.h"
 #include "EncoderAnalog.h"
 #include "EncoderWheel.h"
+#include "Executive.h"
+#include "Landmark.h"
 #include "Motor.h"
 #include "Navigator.h"
 #include "Odometry.h"
 #include "LineSensor.h"
+#include "MoveLog.h"
 #include "xsens.h"
 
 // Skills bot mogo tipper ports
@@ -37,9 +40,11 @@ EncoderWheel encoderWheelR;
 EncoderWheel encoderWheelM;
 struct XsensVex xsens;
 Odometry odometry;
+LandmarkCorrector landmarkCorrector;
 
 Drive drive;
 Navigator navigator;
+MoveLog moveLog;
 
 LineSensor leftLine;
 LineSensor rightLine;
@@ -50,19 +55,77 @@ LineSensor rightBarDetect;
 
 LineSensor mogoDetect;
 
-Ultrasonic front_left_sonar;
-Ultrasonic front_right_sonar;
+// SonarSampler indices.
+int front_left_sonar;
+int front_right_sonar;
 
 PidController liftController;
 
+// Jobs of the executive, indexing executiveJobs.
+typedef enum ExecutiveJobId {
+	JobOdometry,
+	JobAnalog,
+	JobEncoderAnalog,
+	JobLandmarks,
+	JobSonar,
+	JobLift,
+	JobMogo,
+	JobIntake,
+	JobDebug,
+	JobCount
+} ExecutiveJobId;
+
+extern ExecutiveJob executiveJobs[JobCount];
+Executive executive;
+
 extern PidController* pidTuneController;
 
 void pidTuneTask(void *p);
 
+// Given by the mechanism tasks whenever a mechanism finishes its command.
+Semaphore mechanismSemaphore;
+
+#ifndef MAX_DELAY
+// The infinite blockTime of semaphoreTake and mutexTake, under its later PROS name.
+#define MAX_DELAY ((unsigned long) -1)
+#endif
+
+typedef enum Mechanism {
+	MechanismMogo = 0x01,
+	MechanismLift = 0x02,
+	MechanismIntake = 0x04,
+} Mechanism;
+
+typedef enum WaitStatus {
+	WaitDone,
+	WaitTimedOut,
+} WaitStatus;
+
+/**
+ * Blocks until all, or any when all is false, of the Mechanism flags in mechanisms are done
+ * with their last command, or timeout ms pass; a timeout of MAX_DELAY waits forever. Wakes as
+ * soon as a mechanism task signals, so only one task should wait at a time.
+ */
+WaitStatus waitForMechanisms(unsigned int mechanisms, bool all, unsigned long timeout);
+
+/**
+ * Test entry point over serial: 'a' runs autonomous, 'c' and 't' run identifyCoast for drives
+ * and turns.
+ */
 void compControlTask();
 
+/**
+ * Coast-down identification for the Navigator coast models. Runs tests at several powers, fits
+ * a model and installs it on the navigator; the fitted coefficients are printed so they can be
+ * copied into initialize(). Drives the robot at up to full power, so it is only run from
+ * compControlTask.
+ */
+void identifyCoast(bool isTurn);
+
 void odometryTask();
 
+void landmarkTask();
+
 void debugTask();
 
 typedef enum MogoState {
@@ -80,10 +143,31 @@ void mogoDownSlow();
 
 int getMogoPosition();
 
+/**
+ * End of travel sensing for the mogo. A potentiometer on analog port potPort, or 0 for none,
+ * reads upPosition and downPosition at the ends of the travel; readings within endBand of an end
+ * count as there, and equal ends leave only stall detection. The mogo has stalled at an end once
+ * the reading changes slower than stallSpeed per second for stallTime ms while it is powered,
+ * counting only from stallGrace ms after each phase starts, once the motor has spun up. Without a sensor every command runs for its full time.
+ */
+typedef struct MogoTuning {
+	unsigned char potPort;
+	int upPosition;
+	int downPosition;
+	int endBand;
+	double stallSpeed;
+	unsigned long stallTime;
+	unsigned long stallGrace;
+} MogoTuning;
+
+MogoTuning mogoTuning;
+
 void mogoTask();
 
 void waitUntilMogo();
 
+bool isMogoDone();
+
 typedef enum LiftState {
 	LiftUp,
 	LiftDown,
@@ -102,6 +186,8 @@ void liftLoads();
 void liftPickupLoads();
 void waitUntilLift();
 
+bool isLiftDone();
+
 int getLiftPosition();
 
 void liftTask();
@@ -121,6 +207,41 @@ void intakeOut();
 
 void intakeNone();
 
+/**
+ * Tuning of the intake's roller speed control. Speeds are in roller encoder counts per second;
+ * the encoder doesn't sense direction, so speeds are magnitudes. The rollers are expected to
+ * follow power * maxSpeed with a first-order lag of timeConstant seconds. Once the measured
+ * speed falls short of that by more than a residual share of it, the shortfall accumulates,
+ * and the intake trips once it adds up to confidence seconds: a cone is acquired while taking
+ * in and the intake holds, or it jams while running out and the rollers stop. Full in runs the
+ * rollers at full power and never trips.
+ */
+typedef struct IntakeTuning {
+	double maxSpeed;
+	double timeConstant;
+	double Kp;
+	double inSpeed;
+	double outSpeed;
+	double holdPower;
+	double acquiredResidual;
+	double jamResidual;
+	double confidence;
+} IntakeTuning;
+
+IntakeTuning intakeTuning;
+
+/**
+ * True once the intake is holding or stopped again after its last command, on its own after
+ * acquiring a cone or jamming, or because it was told to. Out and full in run until the next
+ * command, so intakeOut is only done once it jams and intakeFullIn never is; wait on either
+ * with a timeout.
+ */
+bool isIntakeDone();
+
+bool intakeHasCone();
+
+bool intakeIsJammed();
+
 void intakeTask();
 
 #endif  // GLOBALS_H_
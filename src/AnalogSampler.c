@@ -0,0 +1,109 @@
+#include "AnalogSampler.h"
+
+#include "API.h"
+#include "log.h"
+
+static AnalogChannel channels[ANALOG_SAMPLER_CHANNELS];
+
+static AnalogChannel* analogSamplerChannel(unsigned char port) {
+	if (port < 1 || port > ANALOG_SAMPLER_CHANNELS) {
+		logError("analogSamplerChannel", "port out of range");
+		return NULL;
+	}
+	return &channels[port - 1];
+}
+
+static int analogSamplerOversample(unsigned char port) {
+	int sum = 0;
+	for (unsigned int i = 0; i < ANALOG_SAMPLER_OVERSAMPLE; i++) {
+		sum += analogRead(port);
+	}
+	return sum / ANALOG_SAMPLER_OVERSAMPLE;
+}
+
+void analogSamplerEnable(unsigned char port) {
+	AnalogChannel* channel = analogSamplerChannel(port);
+	if (!channel || channel->isEnabled) {
+		return;
+	}
+	const int value = analogSamplerOversample(port);
+	for (unsigned int i = 0; i < ANALOG_SAMPLER_HISTORY; i++) {
+		channel->history[i] = value;
+	}
+	channel->next = 0;
+	channel->value = value;
+	channel->isEnabled = true;
+}
+
+void analogSamplerSetThresholds(unsigned char port, int low, int high) {
+	AnalogChannel* channel = analogSamplerChannel(port);
+	if (!channel) {
+		return;
+	}
+	analogSamplerEnable(port);
+	channel->low = low;
+	channel->high = high;
+	channel->isLow = channel->value < low;
+	channel->hasThresholds = true;
+}
+
+int analogSamplerValue(unsigned char port) {
+	const AnalogChannel* channel = analogSamplerChannel(port);
+	if (!channel) {
+		return 0;
+	}
+	return channel->isEnabled ? channel->value : analogRead(port);
+}
+
+bool analogSamplerIsLow(unsigned char port) {
+	const AnalogChannel* channel = analogSamplerChannel(port);
+	return channel ? channel->isLow : false;
+}
+
+unsigned int analogSamplerEdgeCount(unsigned char port) {
+	const AnalogChannel* channel = analogSamplerChannel(port);
+	return channel ? channel->edgeCount : 0;
+}
+
+bool analogSamplerEdge(unsigned char port, unsigned int index, AnalogEdge* edge) {
+	const AnalogChannel* channel = analogSamplerChannel(port);
+	if (!channel || !edge) {
+		return false;
+	}
+	const unsigned int count = channel->edgeCount;
+	if (index >= count || count - index > ANALOG_SAMPLER_EDGES) {
+		return false;
+	}
+	*edge = channel->edges[index % ANALOG_SAMPLER_EDGES];
+	// The sampler may have lapped the edge while it was copied.
+	return channel->edgeCount - index <= ANALOG_SAMPLER_EDGES;
+}
+
+void analogSamplerTask() {
+	for (unsigned char port = 1; port <= ANALOG_SAMPLER_CHANNELS; port++) {
+		AnalogChannel* channel = &channels[port - 1];
+		if (!channel->isEnabled) {
+			continue;
+		}
+		const unsigned long t = micros();
+		channel->history[channel->next] = analogSamplerOversample(port);
+		channel->next = (channel->next + 1) % ANALOG_SAMPLER_HISTORY;
+		int sum = 0;
+		for (unsigned int i = 0; i < ANALOG_SAMPLER_HISTORY; i++) {
+			sum += channel->history[i];
+		}
+		channel->value = sum / ANALOG_SAMPLER_HISTORY;
+
+		if (!channel->hasThresholds) {
+			continue;
+		}
+		const bool isLow = channel->isLow ? (channel->value <= channel->high)
+				: (channel->value < channel->low);
+		if (isLow != channel->isLow) {
+			channel->isLow = isLow;
+			channel->edges[channel->edgeCount % ANALOG_SAMPLER_EDGES] =
+					(AnalogEdge) {.time = t, .isLow = isLow};
+			channel->edgeCount++;
+		}
+	}
+}
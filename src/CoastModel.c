@@ -0,0 +1,48 @@
+#include "CoastModel.h"
+
+#include "log.h"
+
+#include <math.h>
+
+CoastModel coastModelCreate(double linear, double quadratic) {
+	return (CoastModel) {.linear = linear, .quadratic = quadratic};
+}
+
+double coastModelStoppingDistance(const CoastModel* coastModel, double velocity) {
+	if (!coastModel) {
+		logError("coastModelStoppingDistance", "coastModel NULL");
+		return 0.0;
+	}
+	const double speed = fabs(velocity);
+	return copysign(coastModel->linear * speed + coastModel->quadratic * speed * speed, velocity);
+}
+
+CoastModel coastModelFit(const CoastSample* samples, unsigned int count) {
+	if (!samples) {
+		logError("coastModelFit", "samples NULL");
+		return (CoastModel) {};
+	}
+	double v2 = 0.0;
+	double v3 = 0.0;
+	double v4 = 0.0;
+	double dv = 0.0;
+	double dv2 = 0.0;
+	for (unsigned int i = 0; i < count; i++) {
+		const double v = fabs(samples[i].velocity);
+		const double d = fabs(samples[i].distance);
+		v2 += v * v;
+		v3 += v * v * v;
+		v4 += v * v * v * v;
+		dv += d * v;
+		dv2 += d * v * v;
+	}
+	if (v2 < 0.000001) {
+		return (CoastModel) {};
+	}
+	const double determinant = v2 * v4 - v3 * v3;
+	if (fabs(determinant) < 0.000001 * v2 * v4) {
+		return (CoastModel) {.linear = dv / v2, .quadratic = 0.0};
+	}
+	return (CoastModel) {.linear = (dv * v4 - dv2 * v3) / determinant,
+			.quadratic = (v2 * dv2 - v3 * dv) / determinant};
+}
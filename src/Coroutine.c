@@ -0,0 +1,67 @@
+#include "Coroutine.h"
+
+#include "API.h"
+#include "log.h"
+
+CoroutineGroup coroutineGroupCreate() {
+	return (CoroutineGroup) {.count = 0};
+}
+
+int coroutineGroupSpawn(CoroutineGroup* group, CoroutineFunction function, void* arg) {
+	if (!group) {
+		logError("coroutineGroupSpawn", "group NULL");
+		return -1;
+	}
+	if (!function) {
+		logError("coroutineGroupSpawn", "function NULL");
+		return -1;
+	}
+	if (group->count >= COROUTINE_GROUP_SIZE) {
+		logError("coroutineGroupSpawn", "group full");
+		return -1;
+	}
+	group->tracks[group->count] = (CoroutineTrack) {.function = function, .arg = arg,
+			.coroutine = (Coroutine) {}, .isDone = false};
+	return (int) group->count++;
+}
+
+bool coroutineGroupIsDone(const CoroutineGroup* group, int track) {
+	if (!group) {
+		logError("coroutineGroupIsDone", "group NULL");
+		return true;
+	}
+	if (track < 0 || (unsigned int) track >= group->count) {
+		return true;
+	}
+	return group->tracks[track].isDone;
+}
+
+unsigned int coroutineGroupRun(CoroutineGroup* group) {
+	if (!group) {
+		logError("coroutineGroupRun", "group NULL");
+		return 0;
+	}
+	unsigned int running = 0;
+	for (unsigned int i = 0; i < group->count; i++) {
+		CoroutineTrack* track = &group->tracks[i];
+		if (track->isDone) {
+			continue;
+		}
+		track->isDone = track->function(&track->coroutine, track->arg) == CoroutineDone;
+		if (!track->isDone) {
+			running++;
+		}
+	}
+	return running;
+}
+
+void coroutineGroupJoin(CoroutineGroup* group, unsigned long period) {
+	if (!group) {
+		logError("coroutineGroupJoin", "group NULL");
+		return;
+	}
+	unsigned long wakeTime = millis();
+	while (coroutineGroupRun(group) > 0) {
+		taskDelayUntil(&wakeTime, period);
+	}
+}
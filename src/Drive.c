@@ -1,10 +1,14 @@
 #include "Drive.h"
 
+#include "API.h"
 #include "log.h"
 #include "Motor.h"
+#include "Odometry.h"
 #include "PidController.h"
+#include "util.h"
 
 #include <math.h>
+#include <stdlib.h>
 
 Drive driveCreate(Motor* motorLeft, Motor* motorRight, Motor* motorLeft2, Motor* motorRight2) {
 	if (!motorLeft) {
@@ -91,3 +95,41 @@ void driveSetPowerRight(const Drive* drive, double power) {
 	}
 	driveSetPwmRight(drive, powerToPwm(power));
 }
+
+int driveGetPwmMax(const Drive* drive) {
+	if (!drive) {
+		logError("driveGetPwmMax", "drive NULL");
+		return 0;
+	}
+	const int pwmLeft = abs(motorGetPwm(drive->motorLeft));
+	const int pwmRight = abs(motorGetPwm(drive->motorRight));
+	return (pwmLeft > pwmRight) ? pwmLeft : pwmRight;
+}
+
+void driveBrake(const Drive* drive, Odometry* odometry, double gain, double maxPower,
+		double stopVelocity, unsigned long timeout) {
+	if (!drive) {
+		logError("driveBrake", "drive NULL");
+		return;
+	}
+	if (!odometry) {
+		logError("driveBrake", "odometry NULL");
+		return;
+	}
+	const unsigned long timestamp = millis();
+	unsigned long lastSample = odometrySampleCount(odometry);
+
+	while (millis() - timestamp < timeout) {
+		const double velocityL = odometry->velocityL;
+		const double velocityR = odometry->velocityR;
+		if (fabs(velocityL) < stopVelocity && fabs(velocityR) < stopVelocity) {
+			break;
+		}
+		driveSetPower(drive, clampAbs(-gain * velocityL, maxPower),
+				clampAbs(-gain * velocityR, maxPower));
+		if (!odometryWaitForSamples(odometry, &lastSample, 1, 10)) {
+			lastSample = odometrySampleCount(odometry);
+		}
+	}
+	driveSetPowerAll(drive, 0.0);
+}
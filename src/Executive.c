@@ -0,0 +1,116 @@
+#include "Executive.h"
+
+#include "API.h"
+#include "log.h"
+
+Executive executiveCreate(ExecutiveJob* jobs, unsigned int count) {
+	if (!jobs) {
+		logError("executiveCreate", "jobs NULL");
+		return (Executive) {};
+	}
+	return (Executive) {.jobs = jobs, .count = count, .task = NULL};
+}
+
+// Returns the due job with the lowest priority value, or NULL if none are due.
+static ExecutiveJob* executiveNextJob(Executive* executive, unsigned long now) {
+	ExecutiveJob* next = NULL;
+	for (unsigned int i = 0; i < executive->count; i++) {
+		ExecutiveJob* job = &executive->jobs[i];
+		if (job->isEnabled && (long) (now - job->nextRelease) >= 0
+				&& (!next || job->priority < next->priority)) {
+			next = job;
+		}
+	}
+	return next;
+}
+
+static void executiveRunJob(ExecutiveJob* job) {
+	const unsigned long start = micros();
+	job->function();
+	const unsigned long runtime = micros() - start;
+
+	job->runs++;
+	job->totalMicros += runtime;
+	if (runtime > job->maxMicros) {
+		job->maxMicros = runtime;
+	}
+	job->nextRelease += job->period;
+	// Finishing at or after the next release is a miss; skip the releases it ran over.
+	if ((long) (millis() - job->nextRelease) >= 0) {
+		job->misses++;
+		while ((long) (millis() - job->nextRelease) >= 0) {
+			job->nextRelease += job->period;
+		}
+	}
+}
+
+static void executiveTask(void* parameter) {
+	Executive* executive = parameter;
+	unsigned long wakeTime = millis();
+	while (true) {
+		ExecutiveJob* job;
+		while ((job = executiveNextJob(executive, millis())) != NULL) {
+			executiveRunJob(job);
+		}
+		taskDelayUntil(&wakeTime, 1);
+	}
+}
+
+void executiveStart(Executive* executive) {
+	if (!executive) {
+		logError("executiveStart", "executive NULL");
+		return;
+	}
+	if (executive->task) {
+		return;
+	}
+	executive->task = taskCreate(executiveTask, TASK_DEFAULT_STACK_SIZE, executive,
+			TASK_PRIORITY_DEFAULT + 1);
+}
+
+void executiveEnable(Executive* executive, unsigned int job, unsigned long period) {
+	if (!executive) {
+		logError("executiveEnable", "executive NULL");
+		return;
+	}
+	if (job >= executive->count) {
+		logError("executiveEnable", "job out of range");
+		return;
+	}
+	ExecutiveJob* entry = &executive->jobs[job];
+	if (entry->isEnabled && (period == 0 || period == entry->period)) {
+		return;
+	}
+	entry->isEnabled = false;
+	if (period != 0) {
+		entry->period = period;
+	}
+	entry->nextRelease = millis() + entry->phase;
+	entry->isEnabled = true;
+}
+
+void executiveDisable(Executive* executive, unsigned int job) {
+	if (!executive) {
+		logError("executiveDisable", "executive NULL");
+		return;
+	}
+	if (job >= executive->count) {
+		logError("executiveDisable", "job out of range");
+		return;
+	}
+	executive->jobs[job].isEnabled = false;
+}
+
+void executivePrintStats(const Executive* executive, PROS_FILE* stream) {
+	if (!executive) {
+		logError("executivePrintStats", "executive NULL");
+		return;
+	}
+	fprintf(stream, "job,name,period,runs,meanUs,maxUs,misses\n");
+	for (unsigned int i = 0; i < executive->count; i++) {
+		const ExecutiveJob* job = &executive->jobs[i];
+		fprintf(stream, "job,%s,%lu,%lu,%lu,%lu,%lu\n", job->name, job->period, job->runs,
+				job->runs ? (unsigned long) (job->totalMicros / job->runs) : 0UL, job->maxMicros,
+				job->misses);
+	}
+}
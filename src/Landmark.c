@@ -0,0 +1,140 @@
+#include "Landmark.h"
+
+#include "AnalogSampler.h"
+#include "API.h"
+#include "log.h"
+#include "Odometry.h"
+#include "util.h"
+
+#include <math.h>
+
+// How long before an edge the sensor's motion is measured from, in us.
+static const unsigned long kLandmarkApproachTime = 20000;
+
+LandmarkCorrector landmarkCorrectorCreate(Odometry* odometry, const Landmark* landmarks,
+		unsigned int landmarkCount, LandmarkSensor* sensors, unsigned int sensorCount,
+		double matchDistance, double maxCorrection, double gain) {
+	if (!odometry) {
+		logError("landmarkCorrectorCreate", "odometry NULL");
+		return (LandmarkCorrector) {};
+	}
+	if (!landmarks || !sensors) {
+		logError("landmarkCorrectorCreate", "landmarks or sensors NULL");
+		return (LandmarkCorrector) {};
+	}
+	// Only edges from now on are matched.
+	for (unsigned int i = 0; i < sensorCount; i++) {
+		sensors[i].nextEdge = analogSamplerEdgeCount(sensors[i].port);
+	}
+	return (LandmarkCorrector) {.odometry = odometry, .landmarks = landmarks,
+			.landmarkCount = landmarkCount, .sensors = sensors, .sensorCount = sensorCount,
+			.matchDistance = matchDistance, .maxCorrection = maxCorrection, .gain = gain,
+			.corrections = 0, .rejections = 0};
+}
+
+// Line sensors read low over a line; bar detectors read high, above ambient, over a bar.
+static bool landmarkIsSeenLow(LandmarkType type) {
+	return type == LandmarkLine;
+}
+
+// Distance from (x, y) to the landmark's segment.
+static double landmarkDistance(const Landmark* landmark, double x, double y) {
+	const double dx = landmark->end.x - landmark->start.x;
+	const double dy = landmark->end.y - landmark->start.y;
+	const double lengthSquared = dx * dx + dy * dy;
+	const double u = (lengthSquared > 0.0) ? clamp(((x - landmark->start.x) * dx
+			+ (y - landmark->start.y) * dy) / lengthSquared, 0.0, 1.0) : 0.0;
+	return hypot(x - (landmark->start.x + u * dx), y - (landmark->start.y + u * dy));
+}
+
+// Where the sensor was on the field at the pose.
+static void landmarkSensorPlace(const LandmarkSensor* sensor, const Pose* pose, double* x,
+		double* y) {
+	*x = pose->x + sensor->x * cos(pose->theta) - sensor->y * sin(pose->theta);
+	*y = pose->y + sensor->x * sin(pose->theta) + sensor->y * cos(pose->theta);
+}
+
+// Handles an edge the sensor saw at time. Returns false, leaving the edge for the next update,
+// while odometry hasn't recorded a pose that late yet.
+static bool landmarkCorrectorHandle(LandmarkCorrector* corrector, const LandmarkSensor* sensor,
+		unsigned long time) {
+	if (!odometryHasReached(corrector->odometry, time)) {
+		return false;
+	}
+	Pose pose;
+	if (!odometryPoseAt(corrector->odometry, time, &pose)) {
+		corrector->rejections++;
+		return true;
+	}
+	double x;
+	double y;
+	landmarkSensorPlace(sensor, &pose, &x, &y);
+
+	const Landmark* nearest = NULL;
+	double nearestDistance = corrector->matchDistance;
+	for (unsigned int i = 0; i < corrector->landmarkCount; i++) {
+		const Landmark* landmark = &corrector->landmarks[i];
+		if (landmark->type != sensor->type) {
+			continue;
+		}
+		const double distance = landmarkDistance(landmark, x, y);
+		if (distance <= nearestDistance) {
+			nearest = landmark;
+			nearestDistance = distance;
+		}
+	}
+	if (!nearest) {
+		corrector->rejections++;
+		return true;
+	}
+
+	const double length = hypot(nearest->end.x - nearest->start.x,
+			nearest->end.y - nearest->start.y);
+	if (length <= 0.0) {
+		corrector->rejections++;
+		return true;
+	}
+	const double normalX = -(nearest->end.y - nearest->start.y) / length;
+	const double normalY = (nearest->end.x - nearest->start.x) / length;
+	const double offset = (x - nearest->start.x) * normalX + (y - nearest->start.y) * normalY;
+
+	// The sensor sees the landmark's near edge, on the side it came from. Its motion across the
+	// landmark tells the side; without it, the side it was placed on has to do.
+	double across = offset;
+	Pose previous;
+	if (odometryPoseAt(corrector->odometry, time - kLandmarkApproachTime, &previous)) {
+		double previousX;
+		double previousY;
+		landmarkSensorPlace(sensor, &previous, &previousX, &previousY);
+		const double motion = (x - previousX) * normalX + (y - previousY) * normalY;
+		if (motion != 0.0) {
+			across = -motion;
+		}
+	}
+	const double edge = copysign(nearest->width / 2.0, across);
+
+	const double correction = clampAbs(-corrector->gain * (offset - edge),
+			corrector->maxCorrection);
+	odometryShiftPose(corrector->odometry, correction * normalX, correction * normalY);
+	corrector->corrections++;
+	return true;
+}
+
+void landmarkCorrectorUpdate(LandmarkCorrector* corrector) {
+	if (!corrector) {
+		logError("landmarkCorrectorUpdate", "corrector NULL");
+		return;
+	}
+	for (unsigned int i = 0; i < corrector->sensorCount; i++) {
+		LandmarkSensor* sensor = &corrector->sensors[i];
+		const unsigned int count = analogSamplerEdgeCount(sensor->port);
+		AnalogEdge edge;
+		for (; sensor->nextEdge != count; sensor->nextEdge++) {
+			if (analogSamplerEdge(sensor->port, sensor->nextEdge, &edge)
+					&& edge.isLow == landmarkIsSeenLow(sensor->type)
+					&& !landmarkCorrectorHandle(corrector, sensor, edge.time)) {
+				break;
+			}
+		}
+	}
+}
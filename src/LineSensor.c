@@ -1,5 +1,6 @@
 #include "LineSensor.h"
 
+#include "AnalogSampler.h"
 #include "API.h"
 #include "log.h"
 #include "util.h"
@@ -8,12 +9,24 @@
 
 LineSensor lineSensorCreate(unsigned char port, int toggle)
 {
+  analogSamplerSetThresholds(port, toggle - LINE_SENSOR_HYSTERESIS, toggle + LINE_SENSOR_HYSTERESIS);
   return (LineSensor) {.toggle_level = toggle, .port = port};
 }
 
+int lineSensorValue(const LineSensor* lineSensor)
+{
+  if (!lineSensor) {
+    logError("lineSensorValue", "lineSensor NULL");
+    return 0;
+  }
+  return analogSamplerValue(lineSensor->port);
+}
+
 int lineSensorHasLine(const LineSensor* lineSensor)
 {
-  int val = analogRead(lineSensor->port);
-  printf("Line = %d\n", val);
-  return (int)(val < lineSensor->toggle_level);
+  if (!lineSensor) {
+    logError("lineSensorHasLine", "lineSensor NULL");
+    return 0;
+  }
+  return (int) analogSamplerIsLow(lineSensor->port);
 }
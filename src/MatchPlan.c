@@ -0,0 +1,172 @@
+#include "MatchPlan.h"
+
+#include "API.h"
+#include "log.h"
+
+MatchPlan matchPlanCreate(MatchStep* steps, unsigned int count, unsigned long budget) {
+	if (!steps) {
+		logError("matchPlanCreate", "steps NULL");
+		return (MatchPlan) {};
+	}
+	for (unsigned int i = 0; i < count; i++) {
+		steps[i].status = MatchStepPending;
+		steps[i].planned = MatchStepPending;
+		steps[i].duration = 0;
+	}
+	return (MatchPlan) {.steps = steps, .count = count, .budget = budget,
+			.startTime = millis()};
+}
+
+void matchPlanStart(MatchPlan* matchPlan) {
+	if (!matchPlan) {
+		logError("matchPlanStart", "matchPlan NULL");
+		return;
+	}
+	matchPlan->startTime = millis();
+}
+
+unsigned long matchPlanRemaining(const MatchPlan* matchPlan) {
+	if (!matchPlan) {
+		logError("matchPlanRemaining", "matchPlan NULL");
+		return 0;
+	}
+	const unsigned long elapsed = millis() - matchPlan->startTime;
+	return elapsed < matchPlan->budget ? matchPlan->budget - elapsed : 0;
+}
+
+static unsigned long matchStepEstimate(const MatchStep* step, MatchStepStatus status) {
+	if (status == MatchStepRan) {
+		return step->estimate;
+	}
+	return (status == MatchStepRanShort) ? step->shortEstimate : 0;
+}
+
+static double matchStepValue(const MatchStep* step, MatchStepStatus status) {
+	if (status == MatchStepRan) {
+		return step->value;
+	}
+	return (status == MatchStepRanShort) ? step->shortValue : 0.0;
+}
+
+static const MatchStepStatus kMatchStepOptions[] = {MatchStepRan, MatchStepRanShort,
+		MatchStepSkipped};
+
+// Plans the first MATCH_PLAN_SEARCH_STEPS pending steps by trying every full, short and skipped
+// combination and keeping the most valuable one that fits, then the one that skips fewest steps,
+// then the quickest. Later steps wait for the next fit.
+static void matchPlanFit(MatchPlan* matchPlan) {
+	const unsigned long remaining = matchPlanRemaining(matchPlan);
+	MatchStep* pending[MATCH_PLAN_SEARCH_STEPS];
+	unsigned int pendingCount = 0;
+	unsigned int combinations = 1;
+	for (unsigned int i = 0; i < matchPlan->count; i++) {
+		MatchStep* step = &matchPlan->steps[i];
+		if (step->status != MatchStepPending) {
+			continue;
+		}
+		if (pendingCount < MATCH_PLAN_SEARCH_STEPS) {
+			pending[pendingCount++] = step;
+			combinations *= 3;
+		}
+		step->planned = MatchStepSkipped;
+	}
+
+	// Skipping every step always fits.
+	unsigned int best = combinations - 1;
+	double bestValue = 0.0;
+	unsigned int bestSkipped = pendingCount;
+	unsigned long bestTotal = 0;
+	for (unsigned int combination = 0; combination < combinations; combination++) {
+		unsigned long total = 0;
+		double value = 0.0;
+		unsigned int skipped = 0;
+		bool isTrimmed = false;
+		bool isValid = true;
+		unsigned int digits = combination;
+		for (unsigned int i = 0; i < pendingCount && isValid; i++, digits /= 3) {
+			const MatchStep* step = pending[i];
+			const MatchStepStatus option = kMatchStepOptions[digits % 3];
+			if (option == MatchStepRanShort && !step->runShort) {
+				isValid = false;
+			} else if (option == MatchStepSkipped) {
+				skipped++;
+				// Later steps may start where a fixed step ends, so only skip fixed steps at the end.
+				isTrimmed = isTrimmed || !step->isMovable;
+			} else if (isTrimmed) {
+				isValid = false;
+			}
+			total += matchStepEstimate(step, option);
+			value += matchStepValue(step, option);
+		}
+		if (!isValid || total > remaining || value < bestValue
+				|| (value == bestValue && (skipped > bestSkipped
+						|| (skipped == bestSkipped && total >= bestTotal)))) {
+			continue;
+		}
+		best = combination;
+		bestValue = value;
+		bestSkipped = skipped;
+		bestTotal = total;
+	}
+	for (unsigned int i = 0; i < pendingCount; i++, best /= 3) {
+		pending[i]->planned = kMatchStepOptions[best % 3];
+	}
+}
+
+// Returns the step to run next, or NULL once every step has run or been skipped.
+static MatchStep* matchPlanNext(MatchPlan* matchPlan) {
+	unsigned int first = 0;
+	while (first < matchPlan->count && matchPlan->steps[first].status != MatchStepPending) {
+		first++;
+	}
+	if (first == matchPlan->count) {
+		return NULL;
+	}
+	MatchStep* next = &matchPlan->steps[first];
+	if (next->isMovable) {
+		for (unsigned int i = first + 1; i < matchPlan->count && matchPlan->steps[i].isMovable;
+				i++) {
+			MatchStep* step = &matchPlan->steps[i];
+			if (step->status == MatchStepPending && matchStepValue(step, step->planned)
+					> matchStepValue(next, next->planned)) {
+				next = step;
+			}
+		}
+	}
+	return next;
+}
+
+void matchPlanRun(MatchPlan* matchPlan) {
+	if (!matchPlan) {
+		logError("matchPlanRun", "matchPlan NULL");
+		return;
+	}
+	MatchStep* step;
+	while (true) {
+		matchPlanFit(matchPlan);
+		step = matchPlanNext(matchPlan);
+		if (!step) {
+			break;
+		}
+		if (step->planned == MatchStepSkipped) {
+			step->status = MatchStepSkipped;
+		} else {
+			const unsigned long timestamp = millis();
+			if (step->planned == MatchStepRanShort) {
+				step->runShort(step->arg);
+			} else {
+				step->run(step->arg);
+			}
+			step->duration = millis() - timestamp;
+			step->status = step->planned;
+		}
+	}
+
+	for (unsigned int i = 0; i < matchPlan->count; i++) {
+		step = &matchPlan->steps[i];
+		printf("match,%s,%lu,%lu,%s\n", step->name ? step->name : "-",
+				matchStepEstimate(step, step->status), step->duration,
+				step->status == MatchStepRan ? "ran"
+						: (step->status == MatchStepRanShort ? "short" : "skipped"));
+	}
+}
@@ -30,6 +30,14 @@ void motorSetPower(const Motor* motor, double power) {
 	motorSetPwm(motor, powerToPwm(power));
 }
 
+int motorGetPwm(const Motor* motor) {
+	if (!motor) {
+		logError("motorGetPwm", "motor NULL");
+		return 0;
+	}
+	return motor->direction * motorGet(motor->port);
+}
+
 int powerToPwm(double power) {
 	/*double p = fabs(power);
 	if (p < 0.000001) {
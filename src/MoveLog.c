@@ -0,0 +1,100 @@
+#include "MoveLog.h"
+
+#include "API.h"
+#include "log.h"
+
+#include <stdbool.h>
+
+void moveLogClear(MoveLog* moveLog) {
+	if (!moveLog) {
+		logError("moveLogClear", "moveLog NULL");
+		return;
+	}
+	moveLog->next = 0;
+	moveLog->count = 0;
+	moveLog->routine = NULL;
+	moveLog->leg = 0;
+}
+
+void moveLogSetRoutine(MoveLog* moveLog, const char* routine) {
+	if (!moveLog) {
+		logError("moveLogSetRoutine", "moveLog NULL");
+		return;
+	}
+	moveLog->routine = routine;
+	moveLog->leg = 0;
+}
+
+void moveLogAdd(MoveLog* moveLog, MoveRecord record) {
+	if (!moveLog) {
+		logError("moveLogAdd", "moveLog NULL");
+		return;
+	}
+	record.routine = moveLog->routine;
+	record.leg = moveLog->leg++;
+	moveLog->records[moveLog->next] = record;
+	moveLog->next = (moveLog->next + 1) % MOVE_LOG_SIZE;
+	if (moveLog->count < MOVE_LOG_SIZE) {
+		moveLog->count++;
+	}
+}
+
+void moveLogDump(const MoveLog* moveLog, PROS_FILE* stream) {
+	if (!moveLog) {
+		logError("moveLogDump", "moveLog NULL");
+		return;
+	}
+	fprintf(stream, "move,routine,leg,type,start,end,toThreshold,settle,overshoot,finalError,status\n");
+	const unsigned int first = (moveLog->next + MOVE_LOG_SIZE - moveLog->count) % MOVE_LOG_SIZE;
+	for (unsigned int i = 0; i < moveLog->count; i++) {
+		const MoveRecord* record = &moveLog->records[(first + i) % MOVE_LOG_SIZE];
+		const bool reached = record->thresholdTime != 0;
+		fprintf(stream, "move,%s,%u,%s,%lu,%lu,%ld,%ld,%f,%f,%s\n",
+				record->routine ? record->routine : "-", record->leg,
+				moveTypeName((MoveType) record->type), record->startTime, record->endTime,
+				reached ? (long) (record->thresholdTime - record->startTime) : -1L,
+				reached ? (long) (record->endTime - record->thresholdTime) : -1L,
+				(double) record->overshoot, (double) record->finalError,
+				moveStatusName((MoveStatus) record->status));
+	}
+}
+
+const char* moveTypeName(MoveType type) {
+	switch (type) {
+	case MoveDriveToDistance:
+		return "driveToDistance";
+	case MoveTurnToAngle:
+		return "turnToAngle";
+	case MoveArc:
+		return "arc";
+	case MoveAdaptiveDrive:
+		return "adaptiveDrive";
+	case MoveAdaptiveTurn:
+		return "adaptiveTurn";
+	case MoveTrajectory:
+		return "trajectory";
+	case MoveSegments:
+		return "segments";
+	case MoveDriveToPose:
+		return "driveToPose";
+	}
+	return "unknown";
+}
+
+const char* moveStatusName(MoveStatus status) {
+	switch (status) {
+	case MoveSettled:
+		return "settled";
+	case MoveHandedOff:
+		return "handedOff";
+	case MoveStopped:
+		return "stopped";
+	case MoveCompleted:
+		return "completed";
+	case MoveStalled:
+		return "stalled";
+	case MoveTimedOut:
+		return "timedOut";
+	}
+	return "unknown";
+}
@@ -0,0 +1,77 @@
+#include "MoveTrigger.h"
+
+#include "API.h"
+#include "log.h"
+#include "Pose.h"
+
+#include <math.h>
+
+MoveTrigger moveTriggerDistance(double distance, MoveTriggerAction action) {
+	return (MoveTrigger) {.type = MoveTriggerDistance, .value = fabs(distance), .action = action,
+			.hasFired = false};
+}
+
+MoveTrigger moveTriggerFraction(double fraction, MoveTriggerAction action) {
+	return (MoveTrigger) {.type = MoveTriggerFraction, .value = fraction, .action = action,
+			.hasFired = false};
+}
+
+MoveTrigger moveTriggerRegion(Pose center, double radius, MoveTriggerAction action) {
+	return (MoveTrigger) {.type = MoveTriggerRegion, .center = center, .radius = radius,
+			.action = action, .hasFired = false};
+}
+
+MoveTrigger moveTriggerTime(unsigned long time, MoveTriggerAction action) {
+	return (MoveTrigger) {.type = MoveTriggerTime, .value = (double) time, .action = action,
+			.hasFired = false};
+}
+
+static bool moveTriggerIsDue(const MoveTrigger* trigger, double travelled, double fraction,
+		Pose pose, unsigned long elapsed) {
+	switch (trigger->type) {
+	case MoveTriggerDistance:
+		return fabs(travelled) >= trigger->value;
+	case MoveTriggerFraction:
+		return fraction >= trigger->value;
+	case MoveTriggerRegion:
+		return poseDistanceToPoint(pose, trigger->center) <= trigger->radius;
+	case MoveTriggerTime:
+		return (double) elapsed >= trigger->value;
+	}
+	return false;
+}
+
+void moveTriggersUpdate(MoveTrigger* triggers, unsigned int count, double travelled,
+		double fraction, Pose pose, unsigned long elapsed) {
+	if (!triggers) {
+		logError("moveTriggersUpdate", "triggers NULL");
+		return;
+	}
+	for (unsigned int i = 0; i < count; i++) {
+		MoveTrigger* trigger = &triggers[i];
+		if (trigger->hasFired || !moveTriggerIsDue(trigger, travelled, fraction, pose, elapsed)) {
+			continue;
+		}
+		trigger->hasFired = true;
+		if (trigger->action) {
+			trigger->action();
+		}
+	}
+}
+
+void moveTriggersFinish(MoveTrigger* triggers, unsigned int count) {
+	if (!triggers) {
+		logError("moveTriggersFinish", "triggers NULL");
+		return;
+	}
+	for (unsigned int i = 0; i < count; i++) {
+		MoveTrigger* trigger = &triggers[i];
+		if (trigger->hasFired) {
+			continue;
+		}
+		trigger->hasFired = true;
+		if (trigger->action) {
+			trigger->action();
+		}
+	}
+}
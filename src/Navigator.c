@@ -1,9 +1,13 @@
 #include "Navigator.h"
 
+#include "CoastModel.h"
 #include "Drive.h"
 #include "log.h"
+#include "MoveLog.h"
 #include "PidController.h"
 #include "Pose.h"
+#include "RamseteController.h"
+#include "Trajectory.h"
 #include "util.h"
 #include "Vector.h"
 #include "globals.h"
@@ -11,6 +15,12 @@
 #include <math.h>
 #include <stdbool.h>
 
+// Longest odometry job period, in milliseconds.
+static const unsigned long kOdometryPeriod = 5;
+// A control loop runs anyway after this many control ticks without a fresh pose, which leaves
+// room for scheduling jitter and still resyncs quickly when the odometry task has stopped.
+static const unsigned long kPoseTimeoutTicks = 3;
+
 Navigator navigatorCreate(Drive* drive, Odometry* odometry, PidController driveController,
 		PidController straightController, PidController turnController, double deadReckonRadius,
 		double driveDoneThreshold, double turnDoneThreshold, unsigned long doneTime) {
@@ -24,10 +34,311 @@ Navigator navigatorCreate(Drive* drive, Odometry* odometry, PidController driveC
 	}
 	return (Navigator) {.drive = drive, .odometry = odometry,
 			.driveController = driveController, .straightController = straightController,
-			.turnController = turnController, .deadReckonRadius = deadReckonRadius,
+			.turnController = turnController, .useYawRate = true,
+			.ramseteController = ramseteControllerCreate(0.0013, 0.7), .maxVelocity = 60.0,
+			.blendDistance = 4.0, .maxPowerStep = 0.1, .drivePower = 0.0,
+			.deadReckonRadius = deadReckonRadius,
 			.driveDoneThreshold = driveDoneThreshold, .turnDoneThreshold = turnDoneThreshold,
 			.doneTime = doneTime, .isDeadReckoning = false, .deadReckonReference = (Pose) {},
-			.deadReckonVector = (Vector) {}, .timestamp = 0};
+			.deadReckonVector = (Vector) {}, .timestamp = 0, .controlDivider = 5, .lastSample = 0,
+			.stopConditions = NULL,
+			.stopConditionCount = 0, .stoppedBy = -1, .moveLog = NULL, .move = (MoveRecord) {},
+			.moveStartError = 0.0, .moveDepth = 0, .moveStatus = MoveSettled, .stallPower = 0.4,
+			.stallVelocity = 1.0, .stallTime = 300, .stallTimestamp = 0, .moveTimeout = 0,
+			.driveSettleVelocity = 2.0, .turnSettleVelocity = 0.2,
+			.driveCoast = coastModelCreate(0.0, 0.0), .turnCoast = coastModelCreate(0.0, 0.0),
+			.coastBrakePower = 0.0, .brakeOnExit = false, .brakeGain = 0.02, .brakeMaxPower = 0.5,
+			.boomerangLead = 0.6, .arcOffsetGain = 0.1,
+			.direction = NavigatorDirectionForward, .turnRate = 4.0, .reversePenalty = 0,
+			.triggers = NULL, .triggerCount = 0, .moveStartDistance = 0.0};
+}
+
+static int navigatorUntilConditions(const Navigator* navigator, int until,
+		StopCondition* stopConditions) {
+	const int target = (int) navigator->until_target;
+	// Sonar windows kept from the original hard-coded checks: approaching a wall within 20 cm
+	// past |target| when target is negative, within 30 cm short of target when positive.
+	const int sonarLow = (target < 0) ? (-target + 1) : (target - 29);
+	const int sonarHigh = (target < 0) ? (-target + 19) : (target - 1);
+	int count = 0;
+
+	if ((until & UNTIL_LEFT_LINE) != 0) {
+		stopConditions[count++] = stopConditionLine(&leftLine, 1);
+	}
+	if ((until & UNTIL_RIGHT_LINE) != 0) {
+		stopConditions[count++] = stopConditionLine(&rightLine, 1);
+	}
+	if ((until & UNTIL_BACK_LINE) != 0) {
+		stopConditions[count++] = stopConditionLine(&backLine, 1);
+	}
+	if ((until & UNTIL_LEFT_BAR) != 0) {
+		stopConditions[count++] = stopConditionNoLine(&leftBarDetect, 1);
+	}
+	if ((until & UNTIL_RIGHT_BAR) != 0) {
+		stopConditions[count++] = stopConditionNoLine(&rightBarDetect, 1);
+	}
+	if ((until & UNTIL_MOGO_FOUND) != 0) {
+		stopConditions[count++] = stopConditionNoLine(&mogoDetect, 1);
+	}
+	if ((until & UNTIL_FRONT_LEFT_SONAR) != 0) {
+		stopConditions[count++] = stopConditionSonar(&front_left_sonar, sonarLow, sonarHigh, 1);
+	}
+	if ((until & UNTIL_FRONT_RIGHT_SONAR) != 0) {
+		stopConditions[count++] = stopConditionSonar(&front_right_sonar, sonarLow, sonarHigh, 1);
+	}
+	return count;
+}
+
+/**
+ * Waits for the next control tick: every controlDivider-th pose published by the odometry task.
+ */
+static void navigatorWaitForPose(Navigator* navigator) {
+	if (!odometryWaitForSamples(navigator->odometry, &navigator->lastSample,
+			navigator->controlDivider,
+			kPoseTimeoutTicks * navigator->controlDivider * kOdometryPeriod)) {
+		navigator->lastSample = odometrySampleCount(navigator->odometry);
+	}
+}
+
+/**
+ * Turn controller output for a heading error. Damps with the measured yaw rate when
+ * navigator->useYawRate is set, otherwise with the differenced heading error.
+ */
+static double navigatorTurnOutput(Navigator* navigator, double error, unsigned long t) {
+	if (navigator->useYawRate) {
+		return pidControllerComputeOutputWithRate(&navigator->turnController, error,
+				odometryYawRate(navigator->odometry), t);
+	}
+	return pidControllerComputeOutput(&navigator->turnController, error, t);
+}
+
+void navigatorSetStopConditions(Navigator* navigator, StopCondition* stopConditions,
+		unsigned int count) {
+	if (!navigator) {
+		logError("navigatorSetStopConditions", "navigator NULL");
+		return;
+	}
+	for (unsigned int i = 0; i < count; i++) {
+		stopConditionReset(&stopConditions[i]);
+	}
+	navigator->stopConditions = stopConditions;
+	navigator->stopConditionCount = stopConditions ? count : 0;
+	navigator->stoppedBy = -1;
+}
+
+void navigatorClearStopConditions(Navigator* navigator) {
+	navigatorSetStopConditions(navigator, NULL, 0);
+}
+
+// Puts back the conditions an *Until move replaced, leaving stoppedBy as that move set it.
+static void navigatorRestoreStopConditions(Navigator* navigator, StopCondition* stopConditions,
+		unsigned int count) {
+	navigator->stopConditions = stopConditions;
+	navigator->stopConditionCount = count;
+}
+
+static bool navigatorIsStopped(Navigator* navigator) {
+	if (navigator->stopConditionCount == 0) {
+		return false;
+	}
+	navigator->stoppedBy = stopConditionsUpdate(navigator->stopConditions,
+			navigator->stopConditionCount, millis());
+	return navigator->stoppedBy >= 0;
+}
+
+void navigatorSetTriggers(Navigator* navigator, MoveTrigger* triggers, unsigned int count) {
+	if (!navigator) {
+		logError("navigatorSetTriggers", "navigator NULL");
+		return;
+	}
+	if (!triggers && count > 0) {
+		logError("navigatorSetTriggers", "triggers NULL");
+		return;
+	}
+	for (unsigned int i = 0; i < count; i++) {
+		triggers[i].hasFired = false;
+	}
+	navigator->triggers = triggers;
+	navigator->triggerCount = count;
+}
+
+static double navigatorAverageDistance(const Navigator* navigator) {
+	return (encoderWheelDistance(navigator->odometry->encoderWheelL)
+			+ encoderWheelDistance(navigator->odometry->encoderWheelR)) / 2.0;
+}
+
+static double navigatorSlewPower(Navigator* navigator, double power) {
+	navigator->drivePower = clamp(power, navigator->drivePower - navigator->maxPowerStep,
+			navigator->drivePower + navigator->maxPowerStep);
+	return navigator->drivePower;
+}
+
+static void navigatorMoveBegin(Navigator* navigator, MoveType type) {
+	if (navigator->moveDepth++ > 0) {
+		return;
+	}
+	navigator->timestamp = 0;
+	navigator->stallTimestamp = 0;
+	navigator->move = (MoveRecord) {.type = (unsigned char) type, .startTime = millis()};
+	navigator->moveStartError = 0.0;
+	navigator->moveStartDistance = navigatorAverageDistance(navigator);
+}
+
+/**
+ * True once the drive has been commanded at least stallPower while both wheels stayed slower
+ * than stallVelocity for stallTime milliseconds.
+ */
+static bool navigatorIsStalled(Navigator* navigator) {
+	if (navigator->stallTime == 0) {
+		return false;
+	}
+	const Odometry* odometry = navigator->odometry;
+	const bool isPushing = driveGetPwmMax(navigator->drive) >= powerToPwm(navigator->stallPower);
+	const bool isStill = fabs(odometry->velocityL) < navigator->stallVelocity
+			&& fabs(odometry->velocityR) < navigator->stallVelocity;
+	if (!isPushing || !isStill) {
+		navigator->stallTimestamp = 0;
+		return false;
+	}
+	if (navigator->stallTimestamp == 0) {
+		navigator->stallTimestamp = millis();
+		return false;
+	}
+	return (millis() - navigator->stallTimestamp) > navigator->stallTime;
+}
+
+/**
+ * Per-tick bookkeeping shared by every move loop. Updates telemetry for the outermost move, then
+ * decides whether the move is over: a stop condition tripped, the drive stalled, the move's
+ * timeout elapsed, the error is inside threshold and endPower hands off to the next move, the
+ * measured velocity predicts a coast into the threshold, or both the error and the velocity
+ * (yaw rate for turns) have stayed inside their thresholds for doneTime. Sets
+ * navigator->moveStatus to the reason when it returns true.
+ */
+static bool navigatorMoveIsDone(Navigator* navigator, bool isTurn, double error,
+		double threshold, double endPower) {
+	const bool isInside = fabs(error) <= threshold;
+
+	if (navigator->moveDepth == 1) {
+		MoveRecord* move = &navigator->move;
+		if (navigator->moveStartError == 0.0) {
+			navigator->moveStartError = error;
+		}
+		if (isInside && move->thresholdTime == 0) {
+			move->thresholdTime = millis();
+		}
+		const double overshoot = -signum(navigator->moveStartError) * error;
+		if (overshoot > move->overshoot) {
+			move->overshoot = (float) overshoot;
+		}
+		move->finalError = (float) error;
+	}
+	if (navigator->triggerCount > 0 && navigator->moveDepth > 0) {
+		const double fraction = (navigator->moveStartError != 0.0)
+				? 1.0 - error / navigator->moveStartError : 0.0;
+		moveTriggersUpdate(navigator->triggers, navigator->triggerCount,
+				navigatorAverageDistance(navigator) - navigator->moveStartDistance, fraction,
+				navigator->odometry->pose, millis() - navigator->move.startTime);
+	}
+
+	if (navigatorIsStopped(navigator)) {
+		navigator->moveStatus = MoveStopped;
+		return true;
+	}
+	if (navigator->moveDepth > 0) {
+		if (navigatorIsStalled(navigator)) {
+			navigator->moveStatus = MoveStalled;
+			return true;
+		}
+		if (navigator->moveTimeout != 0
+				&& (millis() - navigator->move.startTime) > navigator->moveTimeout) {
+			navigator->moveStatus = MoveTimedOut;
+			return true;
+		}
+	}
+
+	const double velocity = isTurn ? odometryYawRate(navigator->odometry)
+			: odometryVelocity(navigator->odometry);
+	const double settleVelocity = isTurn ? navigator->turnSettleVelocity
+			: navigator->driveSettleVelocity;
+	const double coast = coastModelStoppingDistance(isTurn ? &navigator->turnCoast
+			: &navigator->driveCoast, velocity);
+
+	if (fabs(endPower) > 0.000001) {
+		if (isInside) {
+			navigator->moveStatus = MoveHandedOff;
+			return true;
+		}
+		navigator->timestamp = 0;
+		return false;
+	}
+	// If cutting power now would coast the rest of the way into the threshold, stop driving and
+	// let it.
+	if (signum(velocity) == signum(error) && fabs(coast) > 0.000001
+			&& fabs(error - coast) <= threshold) {
+		navigator->timestamp = 0;
+		navigator->moveStatus = MoveSettled;
+		return true;
+	}
+	if (!isInside || fabs(velocity) > settleVelocity) {
+		navigator->timestamp = 0;
+		return false;
+	}
+	if (navigator->timestamp == 0) {
+		navigator->timestamp = millis();
+	} else if ((millis() - navigator->timestamp) > navigator->doneTime) {
+		navigator->timestamp = 0;
+		navigator->moveStatus = MoveSettled;
+		return true;
+	}
+	return false;
+}
+
+/**
+ * Returns reverse power in place of the controller's power while the coast model predicts the
+ * move would stop more than threshold past the target, so it brakes into the point where cutting
+ * power coasts to the target. Moves that hand off with a non-zero endPower are left alone.
+ */
+static double navigatorCoastPower(const Navigator* navigator, bool isTurn, double error,
+		double threshold, double power, double endPower) {
+	if (fabs(endPower) > 0.000001) {
+		return power;
+	}
+	const double velocity = isTurn ? odometryYawRate(navigator->odometry)
+			: odometryVelocity(navigator->odometry);
+	const double coast = coastModelStoppingDistance(isTurn ? &navigator->turnCoast
+			: &navigator->driveCoast, velocity);
+	if (signum(velocity) == signum(error) && (coast - error) * signum(error) > threshold) {
+		return -signum(velocity) * navigator->coastBrakePower;
+	}
+	return power;
+}
+
+static MoveStatus navigatorMoveEnd(Navigator* navigator, MoveStatus status) {
+	navigator->moveStatus = status;
+	if (--navigator->moveDepth > 0) {
+		return status;
+	}
+	if (navigator->brakeOnExit && status != MoveHandedOff && status != MoveStalled) {
+		driveBrake(navigator->drive, navigator->odometry, navigator->brakeGain,
+				navigator->brakeMaxPower, navigator->driveSettleVelocity, 500);
+		navigator->drivePower = 0.0;
+	}
+	navigator->brakeOnExit = false;
+	navigator->moveTimeout = 0;
+	navigator->direction = NavigatorDirectionForward;
+	// Actions that were sequenced after the move still run when it ends early.
+	if (navigator->triggers) {
+		moveTriggersFinish(navigator->triggers, navigator->triggerCount);
+	}
+	navigator->triggers = NULL;
+	navigator->triggerCount = 0;
+	navigator->move.status = (unsigned char) status;
+	navigator->move.endTime = millis();
+	if (navigator->moveLog) {
+		moveLogAdd(navigator->moveLog, navigator->move);
+	}
+	return status;
 }
 
 void navigatorDriveAtAngle(Navigator* navigator, double angle, double power) {
@@ -53,237 +364,172 @@ void navigatorDriveForTime(Navigator* navigator, double leftPower, double rightP
 	delay(time);
 }
 
-void navigatorDriveToDistance(Navigator* navigator, double distance, double angle, double maxPower, double endPower) {
-	const double target = (encoderWheelDistance(navigator->odometry->encoderWheelL)
-			+ encoderWheelDistance(navigator->odometry->encoderWheelR)) / 2.0 + distance;
+MoveStatus navigatorDriveToDistance(Navigator* navigator, double distance, double angle, double maxPower, double endPower) {
+	const double target = navigatorAverageDistance(navigator) + distance;
 	unsigned long t;
 	double error;
 	double power;
 
+	navigatorMoveBegin(navigator, MoveDriveToDistance);
 	while (true) {
 		t = micros();
-		error = target - (encoderWheelDistance(navigator->odometry->encoderWheelL)
-				+ encoderWheelDistance(navigator->odometry->encoderWheelR)) / 2.0;
+		error = target - navigatorAverageDistance(navigator);
 
-		if (fabs(error) > navigator->driveDoneThreshold) {
-			navigator->timestamp = 0;
-			power = clampAbs(pidControllerComputeOutput(&navigator->driveController, error, t), maxPower);
-			navigatorDriveAtAngle(navigator, angle, power);
-		} else {
-			if (fabs(endPower) > 0.000001) {
-				driveSetPowerAll(navigator->drive, endPower);
-				return;
-			}
-			if (navigator->timestamp == 0) {
-				navigator->timestamp = millis();
-			} else if ((millis() - navigator->timestamp) > navigator->doneTime) {
-				navigator->timestamp = 0;
-				driveSetPowerAll(navigator->drive, endPower);
-				return;
-			}
+		if (navigatorMoveIsDone(navigator, false, error, navigator->driveDoneThreshold, endPower)) {
+			break;
 		}
-		delay(10);
+		power = clampAbs(pidControllerComputeOutput(&navigator->driveController, error, t), maxPower);
+		power = navigatorCoastPower(navigator, false, error, navigator->driveDoneThreshold, power,
+				endPower);
+		navigatorDriveAtAngle(navigator, angle, power);
+		navigatorWaitForPose(navigator);
 	}
+	driveSetPowerAll(navigator->drive, endPower);
+	return navigatorMoveEnd(navigator, navigator->moveStatus);
 }
 
-void navigatorSmoothTurnToAngle(Navigator* navigator, double dir, double angle, double maxPower,
-		double deadPower, double endPower) {
+MoveStatus navigatorArc(Navigator* navigator, double radius, double sweep, double maxPower,
+		double endPower) {
+	if (!navigator) {
+		logError("navigatorArc", "navigator NULL");
+		return MoveStopped;
+	}
+	radius = fabs(radius);
+	if (radius < 0.000001) {
+		logError("navigatorArc", "radius 0");
+		return MoveStopped;
+	}
+	const double direction = (maxPower < 0.0) ? -1.0 : 1.0;
+	const double turn = signum(sweep);
+	const double length = radius * fabs(sweep);
+	const double halfWidth = navigator->odometry->chassisWidth / 2.0;
+	const double start = navigatorAverageDistance(navigator);
+	const Pose startPose = odometryPose(navigator->odometry);
+	// The center of the arc is to the left of the direction of travel when turning
+	// counterclockwise, whichever way the robot is facing.
+	const double side = direction * turn;
+	const Pose center = {.x = startPose.x - side * radius * sin(startPose.theta),
+			.y = startPose.y + side * radius * cos(startPose.theta)};
 	unsigned long t;
 	double error;
-	double power;
 
+	navigatorMoveBegin(navigator, MoveArc);
 	while (true) {
 		t = micros();
-		error = boundAngleNegPiToPi(angle - navigator->odometry->pose.theta);
+		const Pose pose = odometryPose(navigator->odometry);
+		const double traveled = direction * (navigatorAverageDistance(navigator) - start);
+		error = direction * (length - traveled);
 
-		if (fabs(error) > navigator->turnDoneThreshold) {
-			navigator->timestamp = 0;
-			power = clampAbs(pidControllerComputeOutput(&navigator->turnController, error, t), maxPower);
-
-			// Left
-			if (dir < 0) {
-				driveSetPower(navigator->drive, deadPower, power);
-			// Right
-			} else {
-				driveSetPower(navigator->drive, -power, deadPower);
-			}
-		} else {
-			if (fabs(endPower) > 0.000001) {
-				driveSetPower(navigator->drive, -endPower, endPower);
-				return;
-			}
-			if (navigator->timestamp == 0) {
-				navigator->timestamp = millis();
-			} else if ((millis() - navigator->timestamp) > navigator->doneTime) {
-				navigator->timestamp = 0;
-				driveSetPower(navigator->drive, -endPower, endPower);
-				return;
-			}
+		if (navigatorMoveIsDone(navigator, false, error, navigator->driveDoneThreshold, endPower)) {
+			break;
 		}
-		delay(10);
+		double power = clampAbs(pidControllerComputeOutput(&navigator->driveController, error, t),
+				maxPower);
+		power = navigatorCoastPower(navigator, false, error, navigator->driveDoneThreshold, power,
+				endPower);
+
+		// Outside the arc means turning further in the direction of the sweep.
+		const double reference = startPose.theta + turn * fmin(traveled, length) / radius;
+		const double offset = poseDistanceToPoint(pose, center) - radius;
+		const double angleError = boundAngleNegPiToPi(reference - pose.theta)
+				+ turn * navigator->arcOffsetGain * offset;
+		const double correction = pidControllerComputeOutput(&navigator->straightController,
+				angleError, t);
+
+		const double angular = turn * fabs(power) / radius;
+		double powerLeft = power - angular * halfWidth - correction / 2.0;
+		double powerRight = power + angular * halfWidth + correction / 2.0;
+		// Scale both sides together so saturation doesn't change the curvature.
+		const double scale = fmax(fabs(powerLeft), fabs(powerRight)) / fabs(maxPower);
+		if (scale > 1.0) {
+			powerLeft /= scale;
+			powerRight /= scale;
+		}
+		driveSetPower(navigator->drive, powerLeft, powerRight);
+		navigatorWaitForPose(navigator);
 	}
+	driveSetPowerAll(navigator->drive, endPower);
+	return navigatorMoveEnd(navigator, navigator->moveStatus);
 }
 
-void navigatorDriveToDistanceUntil(Navigator* navigator, double distance, double angle,
+MoveStatus navigatorDriveToDistanceUntil(Navigator* navigator, double distance, double angle,
 		double maxPower, double endPower, int until) {
-	const double target = (encoderWheelDistance(navigator->odometry->encoderWheelL)
-			+ encoderWheelDistance(navigator->odometry->encoderWheelR)) / 2.0 + distance;
-	unsigned long t;
-	double error;
-	double power;
-
-	if ((until & UNTIL_FRONT_LEFT_SONAR) != 0) {
-		front_left_sonar = ultrasonicInit(11, 9);
-	}
-
-	if ((until & UNTIL_FRONT_RIGHT_SONAR) != 0) {
-		front_right_sonar = ultrasonicInit(12, 10);
-	}
-
-	while (true) {
-		t = micros();
-		error = target - (encoderWheelDistance(navigator->odometry->encoderWheelL)
-				+ encoderWheelDistance(navigator->odometry->encoderWheelR)) / 2.0;
-
-		if (fabs(error) > navigator->driveDoneThreshold) {
-			navigator->timestamp = 0;
-			power = clampAbs(pidControllerComputeOutput(&navigator->driveController, error, t), maxPower);
-			navigatorDriveAtAngle(navigator, angle, power);
-
-			if ((until & UNTIL_LEFT_LINE) != 0 && lineSensorHasLine(&leftLine)) {
-				break;
-			}
-			if ((until & UNTIL_RIGHT_LINE) != 0 && lineSensorHasLine(&rightLine)) {
-				break;
-			}
-			if ((until & UNTIL_BACK_LINE) != 0 && lineSensorHasLine(&backLine)) {
-				break;
-			}
-			if ((until & UNTIL_LEFT_BAR) != 0 && !lineSensorHasLine(&leftBarDetect)) {
-				break;
-			}
-			if ((until & UNTIL_RIGHT_BAR) != 0 && !lineSensorHasLine(&rightBarDetect)) {
-				break;
-			}
-			if ((until & UNTIL_MOGO_FOUND) != 0 && !lineSensorHasLine(&mogoDetect)) {
-				break;
-			}
-			if ((until & UNTIL_FRONT_LEFT_SONAR) != 0) {
-				int val = ultrasonicGet(front_left_sonar);
-				static int good_count = 0;
-				printf("val = %d \n", val);
-
-				if (val > 0 && sgn(navigator->until_target) * val < navigator->until_target) {
-					if ( navigator->until_target < 0 && val < -navigator->until_target+20) {
-						good_count++;
-					} else if (navigator->until_target > 0 && val > navigator->until_target-30 ){
-						good_count++;
-					}
-
-				} else if (val == -1){ }
-				else {
-					good_count = 0;
-				}
-				if (good_count > 0) {
-					good_count = 0;
-					break;
-				}
-			}
-			if ((until & UNTIL_FRONT_RIGHT_SONAR) != 0) {
-				int val = ultrasonicGet(front_right_sonar);
-				static int good_count_r = 0;
-				printf("val = %d \n", val);
-
-				if (val > 0 && sgn(navigator->until_target) * val < navigator->until_target) {
-					if ( navigator->until_target < 0 && val < -navigator->until_target+20) {
-						good_count_r++;
-					} else if (navigator->until_target > 0 && val > navigator->until_target-30 ){
-						good_count_r++;
-					}
-				} else {
-					good_count_r = 0;
-				}
-				if (good_count_r > 0) {
-					good_count_r = 0;
-					break;
-				}
-			}
-		} else {
-			if (fabs(endPower) > 0.000001) {
-				driveSetPowerAll(navigator->drive, endPower);
-				return;
-			}
-			if (navigator->timestamp == 0) {
-				navigator->timestamp = millis();
-			} else if ((millis() - navigator->timestamp) > navigator->doneTime) {
-				navigator->timestamp = 0;
-				driveSetPowerAll(navigator->drive, endPower);
-				return;
-			}
-		}
-		delay(10);
-	}
-
-	if ((until & UNTIL_FRONT_LEFT_SONAR) != 0) {
-		ultrasonicShutdown(front_left_sonar);
-	}
-
-	if ((until & UNTIL_FRONT_RIGHT_SONAR) != 0) {
-		ultrasonicShutdown(front_right_sonar);
+	if (!navigator) {
+		logError("navigatorDriveToDistanceUntil", "navigator NULL");
+		return MoveStopped;
 	}
+	StopCondition* const savedConditions = navigator->stopConditions;
+	const unsigned int savedCount = navigator->stopConditionCount;
+	StopCondition stopConditions[NAVIGATOR_MAX_UNTIL_CONDITIONS];
+	navigatorSetStopConditions(navigator, stopConditions,
+			(unsigned int) navigatorUntilConditions(navigator, until, stopConditions));
+	MoveStatus status = navigatorDriveToDistance(navigator, distance, angle, maxPower, endPower);
+	navigatorRestoreStopConditions(navigator, savedConditions, savedCount);
 	driveSetPowerAll(navigator->drive, endPower);
+	return status;
 }
 
-void navigatorTurnToAngle(Navigator* navigator, double angle, double maxPower, double endPower) {
+MoveStatus navigatorTurnToAngle(Navigator* navigator, double angle, double maxPower, double endPower) {
 	unsigned long t;
 	double error;
 	double power;
 
+	navigatorMoveBegin(navigator, MoveTurnToAngle);
 	while (true) {
 		t = micros();
 		error = boundAngleNegPiToPi(angle - navigator->odometry->pose.theta);
 
-		if (fabs(error) > navigator->turnDoneThreshold) {
-			navigator->timestamp = 0;
-			power = clampAbs(pidControllerComputeOutput(&navigator->turnController, error, t), maxPower);
-			driveSetPower(navigator->drive, -power, power);
-		} else {
-			if (fabs(endPower) > 0.000001) {
-				driveSetPower(navigator->drive, -endPower, endPower);
-				return;
-			}
-			if (navigator->timestamp == 0) {
-				navigator->timestamp = millis();
-			} else if ((millis() - navigator->timestamp) > navigator->doneTime) {
-				navigator->timestamp = 0;
-				driveSetPower(navigator->drive, -endPower, endPower);
-				return;
-			}
+		if (navigatorMoveIsDone(navigator, true, error, navigator->turnDoneThreshold, endPower)) {
+			break;
 		}
-		delay(10);
+		power = clampAbs(navigatorTurnOutput(navigator, error, t), maxPower);
+		power = navigatorCoastPower(navigator, true, error, navigator->turnDoneThreshold, power,
+				endPower);
+		driveSetPower(navigator->drive, -power, power);
+		navigatorWaitForPose(navigator);
 	}
+	driveSetPower(navigator->drive, -endPower, endPower);
+	return navigatorMoveEnd(navigator, navigator->moveStatus);
 }
 
-void navigatorDriveToPoint(Navigator* navigator, Pose point, double maxPower, double endPower) {
+// True when the move toward heading angle should lead with the back of the robot. Drive time is
+// the same either way, so only the pivot onto the path and the reverse penalty are compared.
+static bool navigatorIsReverse(const Navigator* navigator, double angle, double maxPower) {
+	if (maxPower < 0.0 || navigator->direction == NavigatorDirectionReverse) {
+		return true;
+	}
+	if (navigator->direction == NavigatorDirectionForward || navigator->turnRate <= 0.0) {
+		return false;
+	}
+	const double forwardTurn = fabs(boundAngleNegPiToPi(angle - navigator->odometry->pose.theta));
+	const double forwardTime = 1000.0 * forwardTurn / navigator->turnRate;
+	const double reverseTime = 1000.0 * (kPi - forwardTurn) / navigator->turnRate
+			+ (double) navigator->reversePenalty;
+	return reverseTime < forwardTime;
+}
+
+MoveStatus navigatorDriveToPoint(Navigator* navigator, Pose point, double maxPower, double endPower) {
 	double dx = point.x - navigator->odometry->pose.x;
 	double dy = point.y - navigator->odometry->pose.y;
 	double distance = hypot(dy, dx);
 	double angle = atan2(dy, dx);
-	if (maxPower < 0.0) {
+	if (navigatorIsReverse(navigator, angle, maxPower)) {
 		distance *= -1.0;
 		angle += kPi;
+		// endPower is given along the direction of travel.
+		endPower *= -1.0;
 	}
-	navigatorDriveToDistance(navigator, distance, angle, maxPower, endPower);
+	return navigatorDriveToDistance(navigator, distance, angle, maxPower, endPower);
 }
 
-void navigatorTurnToPoint(Navigator* navigator, Pose point, double maxPower, double endPower) {
+MoveStatus navigatorTurnToPoint(Navigator* navigator, Pose point, double maxPower, double endPower) {
 	double dx = point.x - navigator->odometry->pose.x;
 	double dy = point.y - navigator->odometry->pose.y;
 	double angle = atan2(dy, dx);
-	if (maxPower < 0.0) {
+	if (navigatorIsReverse(navigator, angle, maxPower)) {
 		angle += kPi;
 	}
-	navigatorTurnToAngle(navigator, angle, maxPower, endPower);
+	return navigatorTurnToAngle(navigator, angle, maxPower, endPower);
 }
 
 bool navigatorAdaptiveDriveTowardsPoint(Navigator* navigator, Pose point, double maxPower, double endPower) {
@@ -333,20 +579,10 @@ bool navigatorAdaptiveDriveTowardsPoint(Navigator* navigator, Pose point, double
 
 	driveSetPower(navigator->drive, leftPower, rightPower);
 
-	if (fabs(driveError) < navigator->driveDoneThreshold) {
-		if (fabs(endPower) > 0.000001) {
-			driveSetPowerAll(navigator->drive, endPower);
-			return true;
-		}
-		if (navigator->timestamp == 0) {
-			navigator->timestamp = millis();
-		} else if ((millis() - navigator->timestamp) > navigator->doneTime) {
-			navigator->timestamp = 0;
-			driveSetPowerAll(navigator->drive, endPower);
-			return true;
-		}
-	} else {
-		navigator->timestamp = 0;
+	if (navigatorMoveIsDone(navigator, false, driveError, navigator->driveDoneThreshold,
+			endPower)) {
+		driveSetPowerAll(navigator->drive, endPower);
+		return true;
 	}
 	return false;
 }
@@ -364,66 +600,365 @@ bool navigatorAdaptiveTurnTowardsPoint(Navigator* navigator, Pose point, double
 		// Turn backside towards point.
 		error = boundAngleNegPiToPi(error + kPi);
 	}
-	double power = clampAbs(pidControllerComputeOutput(&navigator->turnController, error, t)
+	double power = clampAbs(navigatorTurnOutput(navigator, error, t)
 			+ endPower, maxPower);
 
 	driveSetPower(navigator->drive, -power, power);
 
-	if (fabs(error) < navigator->turnDoneThreshold) {
-		if (fabs(endPower) > 0.000001) {
-			print("endPower != 0\n");
-			driveSetPower(navigator->drive, -endPower, endPower);
-			return true;
-		}
-		if (navigator->timestamp == 0) {
-			navigator->timestamp = millis();
-		} else if ((millis() - navigator->timestamp) > navigator->doneTime) {
-			navigator->timestamp = 0;
-			driveSetPower(navigator->drive, -endPower, endPower);
-			return true;
-		}
-	} else {
-		navigator->timestamp = 0;
+	if (navigatorMoveIsDone(navigator, true, error, navigator->turnDoneThreshold, endPower)) {
+		driveSetPower(navigator->drive, -endPower, endPower);
+		return true;
 	}
 	return false;
 }
 
-void navigatorAdaptiveDriveToPoint(Navigator* navigator, Pose point, double maxPower, double endPower) {
+MoveStatus navigatorAdaptiveDriveToPoint(Navigator* navigator, Pose point, double maxPower, double endPower) {
 	if (!navigator) {
 		logError("navigatorDriveToPoint", "navigator NULL");
-		return;
+		return MoveStopped;
 	}
+	navigatorMoveBegin(navigator, MoveAdaptiveDrive);
 	while (!navigatorAdaptiveDriveTowardsPoint(navigator, point, maxPower, endPower)) {
-		delay(10);
+		navigatorWaitForPose(navigator);
 	}
-	return;
+	return navigatorMoveEnd(navigator, navigator->moveStatus);
 }
 
-void navigatorAdaptiveDriveToPointUntil(Navigator* navigator, Pose point, double maxPower, double endPower, int until) {
+MoveStatus navigatorAdaptiveDriveToPointUntil(Navigator* navigator, Pose point, double maxPower, double endPower, int until) {
 	if (!navigator) {
 		logError("navigatorDriveToPointUntil", "navigator NULL");
-		return;
+		return MoveStopped;
 	}
-	while (!navigatorAdaptiveDriveTowardsPoint(navigator, point, maxPower, endPower)) {
-		if ((until & UNTIL_LEFT_LINE) != 0 && lineSensorHasLine(&leftLine)) {
-			printf("Break on Left Line Sensor!!\n\n\n");
+	StopCondition* const savedConditions = navigator->stopConditions;
+	const unsigned int savedCount = navigator->stopConditionCount;
+	StopCondition stopConditions[NAVIGATOR_MAX_UNTIL_CONDITIONS];
+	navigatorSetStopConditions(navigator, stopConditions,
+			(unsigned int) navigatorUntilConditions(navigator, until, stopConditions));
+	MoveStatus status = navigatorAdaptiveDriveToPoint(navigator, point, maxPower, endPower);
+	navigatorRestoreStopConditions(navigator, savedConditions, savedCount);
+	driveSetPowerAll(navigator->drive, endPower);
+	return status;
+}
+
+MoveStatus navigatorDriveToPointUntil(Navigator* navigator, Pose point, double maxPower, double endPower, int until) {
+	if (!navigator) {
+		logError("navigatorDriveToPointUntil", "navigator NULL");
+		return MoveStopped;
+	}
+	StopCondition* const savedConditions = navigator->stopConditions;
+	const unsigned int savedCount = navigator->stopConditionCount;
+	StopCondition stopConditions[NAVIGATOR_MAX_UNTIL_CONDITIONS];
+	navigatorSetStopConditions(navigator, stopConditions,
+			(unsigned int) navigatorUntilConditions(navigator, until, stopConditions));
+	MoveStatus status = navigatorDriveToPoint(navigator, point, maxPower, endPower);
+	navigatorRestoreStopConditions(navigator, savedConditions, savedCount);
+	return status;
+}
+
+MoveStatus navigatorAdaptiveTurnToPoint(Navigator* navigator, Pose point, double maxPower, double endPower) {
+	if (!navigator) {
+		logError("navigatorTurnToPoint", "navigator NULL");
+		return MoveStopped;
+	}
+	navigatorMoveBegin(navigator, MoveAdaptiveTurn);
+	while (!navigatorAdaptiveTurnTowardsPoint(navigator, point, maxPower, endPower)) {
+		navigatorWaitForPose(navigator);
+	}
+	return navigatorMoveEnd(navigator, navigator->moveStatus);
+}
+
+MoveStatus navigatorFollowTrajectory(Navigator* navigator, const Trajectory* trajectory, double endPower) {
+	if (!navigator) {
+		logError("navigatorFollowTrajectory", "navigator NULL");
+		return MoveStopped;
+	}
+	if (!trajectory) {
+		logError("navigatorFollowTrajectory", "trajectory NULL");
+		return MoveStopped;
+	}
+	const unsigned long start = millis();
+	const unsigned long duration = trajectoryDuration(trajectory);
+	const double halfWidth = navigator->odometry->chassisWidth / 2.0;
+	MoveStatus status = MoveCompleted;
+	unsigned long t;
+
+	navigatorMoveBegin(navigator, MoveTrajectory);
+	while ((t = millis() - start) <= duration) {
+		TrajectoryPoint reference = trajectorySample(trajectory, t);
+		const double error = poseDistanceToPoint(odometryPose(navigator->odometry), reference.pose);
+		// Tracking error never settles before the reference stops moving, so only stop conditions
+		// can end a trajectory early.
+		if (navigatorMoveIsDone(navigator, false, error, -1.0, 0.0)) {
+			status = navigator->moveStatus;
 			break;
 		}
-		if ((until & UNTIL_RIGHT_LINE) != 0 && lineSensorHasLine(&rightLine)) {
-			printf("Break on Right Line Sensor!!\n\n\n");
+		ramseteControllerComputeOutput(&navigator->ramseteController,
+				odometryPose(navigator->odometry), reference);
+
+		double v = ramseteControllerVelocity(&navigator->ramseteController);
+		double w = ramseteControllerAngularVelocity(&navigator->ramseteController);
+		double powerLeft = (v - w * halfWidth) / navigator->maxVelocity;
+		double powerRight = (v + w * halfWidth) / navigator->maxVelocity;
+
+		// Scale both sides together so saturation doesn't change the commanded curvature.
+		double scale = fmax(fabs(powerLeft), fabs(powerRight));
+		if (scale > 1.0) {
+			powerLeft /= scale;
+			powerRight /= scale;
+		}
+		driveSetPower(navigator->drive, powerLeft, powerRight);
+		navigatorWaitForPose(navigator);
+	}
+	driveSetPowerAll(navigator->drive, endPower);
+	return navigatorMoveEnd(navigator, status);
+}
+
+/**
+ * Power a drive segment should still have when it hands off to the next segment. Zero when the
+ * next segment turns in place, reverses direction, or there is no next segment.
+ */
+static double navigatorSegmentExitPower(const NavigatorSegment* segment,
+		const NavigatorSegment* next) {
+	if (!next || segment->type != NavigatorSegmentDrive || next->type != NavigatorSegmentDrive
+			|| signum(segment->distance) != signum(next->distance)) {
+		return 0.0;
+	}
+	const double turn = boundAngleNegPiToPi(next->angle - segment->angle);
+	const double power = fmin(fabs(segment->maxPower), fabs(next->maxPower)) * fmax(cos(turn), 0.0);
+	return copysign(power, segment->distance);
+}
+
+static MoveStatus navigatorDriveSegment(Navigator* navigator, double target, double length,
+		double entryAngle, double angle, double exitAngle, double maxPower, double exitPower,
+		double endPower) {
+	const double blend = navigator->blendDistance;
+	const bool isBlended = fabs(exitPower) > 0.000001;
+	unsigned long t;
+	double error;
+	double power;
+	double reference;
+
+	while (true) {
+		t = micros();
+		error = target - navigatorAverageDistance(navigator);
+		const double remaining = fabs(error);
+		const double traveled = length - remaining;
+
+		// A blended exit hands off on crossing the threshold, like a non-zero endPower, or on
+		// crossing the target when a tick jumps over the threshold, instead of driving back at
+		// exit power.
+		if (navigatorMoveIsDone(navigator, false, error, navigator->driveDoneThreshold,
+				isBlended ? exitPower : endPower)) {
+			break;
+		}
+		if (isBlended && error * exitPower < 0.0) {
+			navigator->moveStatus = MoveHandedOff;
 			break;
 		}
-		delay(10);
+
+		// Split each corner between the two segments so the heading reference never steps.
+		reference = angle;
+		if (traveled < blend) {
+			reference += boundAngleNegPiToPi(entryAngle - angle) * 0.5 * (1.0 - traveled / blend);
+		}
+		if (isBlended && remaining < blend) {
+			reference += boundAngleNegPiToPi(exitAngle - angle) * 0.5 * (1.0 - remaining / blend);
+		}
+
+		power = clampAbs(pidControllerComputeOutput(&navigator->driveController, error, t), maxPower);
+		if (fabs(power) < fabs(exitPower)) {
+			power = copysign(exitPower, error);
+		}
+		power = navigatorCoastPower(navigator, false, error, navigator->driveDoneThreshold, power,
+				isBlended ? exitPower : endPower);
+		navigatorDriveAtAngle(navigator, reference, navigatorSlewPower(navigator, power));
+		navigatorWaitForPose(navigator);
+	}
+	if (!isBlended || navigator->moveStatus != MoveHandedOff) {
+		navigator->drivePower = endPower;
+		driveSetPowerAll(navigator->drive, endPower);
+	}
+	return navigator->moveStatus;
+}
+
+// Whether a segment ending with status lets the next segment run.
+static bool navigatorIsChainable(MoveStatus status) {
+	return status == MoveSettled || status == MoveHandedOff;
+}
+
+MoveStatus navigatorDriveSegments(Navigator* navigator, const NavigatorSegment* segments,
+		unsigned int count, double endPower) {
+	if (!navigator) {
+		logError("navigatorDriveSegments", "navigator NULL");
+		return MoveStopped;
+	}
+	if (!segments) {
+		logError("navigatorDriveSegments", "segments NULL");
+		return MoveStopped;
+	}
+	navigator->drivePower = odometryVelocity(navigator->odometry) / navigator->maxVelocity;
+	double target = navigatorAverageDistance(navigator);
+	double entryAngle = odometryPose(navigator->odometry).theta;
+	double entryPower = 0.0;
+	MoveStatus status = MoveSettled;
+
+	navigatorMoveBegin(navigator, MoveSegments);
+	// Abort the chain as soon as a segment stops, stalls or times out.
+	for (unsigned int i = 0; i < count && navigatorIsChainable(status); i++) {
+		const NavigatorSegment* segment = &segments[i];
+		const NavigatorSegment* next = (i + 1 < count) ? &segments[i + 1] : NULL;
+		const bool isLast = !next;
+
+		if (segment->type == NavigatorSegmentTurn) {
+			// Hand off as soon as the heading is inside the threshold (any non-zero end power
+			// does); the next segment's straight controller absorbs the residual instead of
+			// waiting to settle.
+			const double exitPower = isLast ? endPower : 1.0;
+			double error;
+			while (true) {
+				error = boundAngleNegPiToPi(segment->angle - navigator->odometry->pose.theta);
+				if (navigatorMoveIsDone(navigator, true, error, navigator->turnDoneThreshold,
+						exitPower)) {
+					break;
+				}
+				double power = clampAbs(navigatorTurnOutput(navigator, error, micros()),
+						segment->maxPower);
+				driveSetPower(navigator->drive, -power, power);
+				navigatorWaitForPose(navigator);
+			}
+			status = navigator->moveStatus;
+			driveSetPower(navigator->drive, isLast ? -endPower : 0.0, isLast ? endPower : 0.0);
+			navigator->drivePower = 0.0;
+			target = navigatorAverageDistance(navigator);
+			entryAngle = segment->angle;
+			entryPower = 0.0;
+			continue;
+		}
+
+		// Chain targets from the planned end of the previous segment so overshoot on one leg
+		// is taken out of the next instead of accumulating.
+		if (fabs(entryPower) < 0.000001) {
+			target = navigatorAverageDistance(navigator);
+		}
+		target += segment->distance;
+		const double exitPower = navigatorSegmentExitPower(segment, next);
+		status = navigatorDriveSegment(navigator, target, fabs(segment->distance),
+				(fabs(entryPower) > 0.000001) ? entryAngle : segment->angle, segment->angle,
+				next ? next->angle : segment->angle, segment->maxPower, exitPower,
+				isLast ? endPower : 0.0);
+		entryAngle = segment->angle;
+		entryPower = exitPower;
+	}
+	if (!navigatorIsChainable(status)) {
+		navigator->drivePower = endPower;
+		driveSetPowerAll(navigator->drive, endPower);
+	}
+	return navigatorMoveEnd(navigator, status);
+}
+
+MoveStatus navigatorDriveToPose(Navigator* navigator, Pose target, double maxPower,
+		double endPower) {
+	if (!navigator) {
+		logError("navigatorDriveToPose", "navigator NULL");
+		return MoveStopped;
+	}
+	const double cosTarget = cos(target.theta);
+	const double sinTarget = sin(target.theta);
+	// Choose the side to lead with from the heading toward the forward carrot.
+	const double startLead = navigator->boomerangLead
+			* poseDistanceToPoint(navigator->odometry->pose, target);
+	const Pose startCarrot = {.x = target.x - startLead * cosTarget,
+			.y = target.y - startLead * sinTarget};
+	if (navigatorIsReverse(navigator, atan2(startCarrot.y - navigator->odometry->pose.y,
+			startCarrot.x - navigator->odometry->pose.x), maxPower) && maxPower > 0.0) {
+		maxPower *= -1.0;
+	}
+	const double direction = (maxPower < 0.0) ? -1.0 : 1.0;
+	// endPower is given along the direction of travel.
+	endPower *= direction;
+	unsigned long t;
+	double driveError;
+
+	navigatorMoveBegin(navigator, MoveDriveToPose);
+	while (true) {
+		t = micros();
+		const Pose pose = odometryPose(navigator->odometry);
+		const double distance = poseDistanceToPoint(pose, target);
+
+		// Pose of the side of the robot that leads, turned around when backing in.
+		Pose facing = pose;
+		if (direction < 0.0) {
+			facing.theta = boundAngleNegPiToPi(pose.theta + kPi);
+		}
+
+		double headingError;
+		if (distance > navigator->deadReckonRadius) {
+			const double lead = direction * navigator->boomerangLead * distance;
+			const Pose carrot = {.x = target.x - lead * cosTarget, .y = target.y - lead * sinTarget};
+			headingError = poseAngleToPoint(facing, carrot);
+		} else {
+			headingError = boundAngleNegPiToPi(target.theta - pose.theta);
+		}
+		// Distance left along the direction of travel; negative once past the target.
+		driveError = direction * distance * cos(poseAngleToPoint(facing, target));
+
+		if (navigatorMoveIsDone(navigator, false, driveError, navigator->driveDoneThreshold,
+				endPower)) {
+			break;
+		}
+		double drivePower = clampAbs(pidControllerComputeOutput(&navigator->driveController,
+				driveError, t), maxPower);
+		drivePower = navigatorCoastPower(navigator, false, driveError,
+				navigator->driveDoneThreshold, drivePower, endPower);
+		const double turnPower = pidControllerComputeOutput(&navigator->straightController,
+				headingError, t);
+
+		double powerLeft = drivePower - turnPower;
+		double powerRight = drivePower + turnPower;
+		// Scale both sides together so saturation doesn't change the curvature.
+		const double scale = fmax(fabs(powerLeft), fabs(powerRight)) / fabs(maxPower);
+		if (scale > 1.0) {
+			powerLeft /= scale;
+			powerRight /= scale;
+		}
+		driveSetPower(navigator->drive, powerLeft, powerRight);
+		navigatorWaitForPose(navigator);
 	}
 	driveSetPowerAll(navigator->drive, endPower);
+	return navigatorMoveEnd(navigator, navigator->moveStatus);
 }
 
-void navigatorAdaptiveTurnToPoint(Navigator* navigator, Pose point, double maxPower, double endPower) {
+CoastSample navigatorMeasureCoast(Navigator* navigator, bool isTurn, double power,
+		unsigned long time) {
 	if (!navigator) {
-		logError("navigatorTurnToPoint", "navigator NULL");
-		return;
+		logError("navigatorMeasureCoast", "navigator NULL");
+		return (CoastSample) {};
 	}
-	while (!navigatorTurnTowardsPoint(navigator, point, maxPower, endPower)) {
-		delay(10);
+	const double settleVelocity = isTurn ? navigator->turnSettleVelocity
+			: navigator->driveSettleVelocity;
+
+	driveSetPower(navigator->drive, isTurn ? -power : power, power);
+	delay(time);
+
+	const double velocity = isTurn ? odometryYawRate(navigator->odometry)
+			: odometryVelocity(navigator->odometry);
+	const double start = isTurn ? navigator->odometry->pose.theta
+			: navigatorAverageDistance(navigator);
+	driveSetPowerAll(navigator->drive, 0.0);
+
+	const unsigned long timestamp = millis();
+	while (millis() - timestamp < 2000) {
+		navigatorWaitForPose(navigator);
+		const double v = isTurn ? odometryYawRate(navigator->odometry)
+				: odometryVelocity(navigator->odometry);
+		if (fabs(v) < settleVelocity / 4.0) {
+			break;
+		}
 	}
+	const double distance = isTurn
+			? boundAngleNegPiToPi(navigator->odometry->pose.theta - start)
+			: (navigatorAverageDistance(navigator) - start);
+
+	printf("coast,%s,%f,%f\n", isTurn ? "turn" : "drive", velocity, distance);
+	return (CoastSample) {.velocity = velocity, .distance = distance};
 }
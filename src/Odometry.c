@@ -9,6 +9,9 @@
 
 #include <math.h>
 
+// Weight given to each new wheel velocity sample by the low-pass filter.
+static const double kVelocityFilterGain = 0.2;
+
 Odometry odometryCreate(EncoderWheel* encoderWheelL, EncoderWheel* encoderWheelR,
 		EncoderWheel* encoderWheelM, struct XsensVex* xsens, double chassisWidth, Pose initialPose) {
 	if (!encoderWheelL) {
@@ -19,7 +22,8 @@ Odometry odometryCreate(EncoderWheel* encoderWheelL, EncoderWheel* encoderWheelR
 		logError("odometryCreate", "encoderWheelR NULL");
 		return (Odometry) {};
 	}
-	Odometry odometry = {.mutex = mutexCreate(), .encoderWheelL = encoderWheelL,
+	Odometry odometry = {.mutex = mutexCreate(), .sampleSemaphore = semaphoreCreate(),
+			.sampleCount = 0, .encoderWheelL = encoderWheelL,
 			.encoderWheelR = encoderWheelR, .encoderWheelM = encoderWheelM, .xsens = xsens,
 			.chassisWidth = chassisWidth};
 	odometrySetPose(&odometry, initialPose);
@@ -34,7 +38,11 @@ void odometryDelete(Odometry* odometry) {
 	if (odometry->mutex) {
 		mutexDelete(odometry->mutex);
 	}
+	if (odometry->sampleSemaphore) {
+		semaphoreDelete(odometry->sampleSemaphore);
+	}
 	odometry->mutex = NULL;
+	odometry->sampleSemaphore = NULL;
 	odometry->encoderWheelL = NULL;
 	odometry->encoderWheelR = NULL;
 	odometry->encoderWheelM = NULL;
@@ -49,6 +57,7 @@ Pose odometryComputePose(Odometry* odometry) {
 	}
 	mutexTake(odometry->mutex, 20);
 
+	const unsigned long t = micros();
 	double dL = encoderWheelDistance(odometry->encoderWheelL) - odometry->lastL;
 	double dR = encoderWheelDistance(odometry->encoderWheelR) - odometry->lastR;
 	double dM = odometry->encoderWheelM ?
@@ -59,6 +68,13 @@ Pose odometryComputePose(Odometry* odometry) {
 	odometry->lastR += dR;
 	odometry->lastM += dM;
 
+	if (odometry->lastTime != 0 && t != odometry->lastTime) {
+		const double dt = (double) (t - odometry->lastTime) / 1000000.0;
+		odometry->velocityL += kVelocityFilterGain * (dL / dt - odometry->velocityL);
+		odometry->velocityR += kVelocityFilterGain * (dR / dt - odometry->velocityR);
+	}
+	odometry->lastTime = t;
+
 	double dS = (dR + dL) / 2;
 	//Pose dPose = {.theta = boundAngleNegPiToPi(yaw - odometry->pose.theta)};
 	Pose dPose;
@@ -75,8 +91,12 @@ Pose odometryComputePose(Odometry* odometry) {
 	dPose.y = dS * sin(avgTheta) - dM * cos(avgTheta);
 
 	poseAdd(&odometry->pose, dPose);
+	odometry->history[odometry->sampleCount % ODOMETRY_HISTORY] =
+			(OdometrySample) {.time = t, .pose = odometry->pose};
+	odometry->sampleCount++;
 
 	mutexGive(odometry->mutex);
+	semaphoreGive(odometry->sampleSemaphore);
 
 	return odometry->pose;
 }
@@ -103,10 +123,140 @@ void odometrySetPose(Odometry* odometry, Pose pose) {
 	odometry->pose.x = pose.x;
 	odometry->pose.y = pose.y;
 	odometry->pose.theta = pose.theta;
+	// Poses from before the reset aren't in the new frame.
+	odometry->historyStart = odometry->sampleCount;
 
 	mutexGive(odometry->mutex);
 }
 
+bool odometryPoseAt(Odometry* odometry, unsigned long time, Pose* pose) {
+	if (!odometry) {
+		logError("odometryPoseAt", "odometry NULL");
+		return false;
+	}
+	if (!pose) {
+		logError("odometryPoseAt", "pose NULL");
+		return false;
+	}
+	mutexTake(odometry->mutex, 20);
+
+	const unsigned long count = odometry->sampleCount;
+	unsigned long oldest = (count > ODOMETRY_HISTORY) ? count - ODOMETRY_HISTORY : 0;
+	if ((long) (odometry->historyStart - oldest) > 0) {
+		oldest = odometry->historyStart;
+	}
+	bool isFound = false;
+	// Walk back from the newest sample to the first one at or before time.
+	for (unsigned long i = count; i > oldest + 1; i--) {
+		const OdometrySample* after = &odometry->history[(i - 1) % ODOMETRY_HISTORY];
+		const OdometrySample* before = &odometry->history[(i - 2) % ODOMETRY_HISTORY];
+		if ((long) (time - after->time) > 0) {
+			break;
+		}
+		if ((long) (time - before->time) >= 0) {
+			const double span = (double) (after->time - before->time);
+			const double f = (span > 0.0) ? (double) (time - before->time) / span : 0.0;
+			pose->x = before->pose.x + f * (after->pose.x - before->pose.x);
+			pose->y = before->pose.y + f * (after->pose.y - before->pose.y);
+			pose->theta = before->pose.theta
+					+ f * boundAngleNegPiToPi(after->pose.theta - before->pose.theta);
+			isFound = true;
+			break;
+		}
+	}
+
+	mutexGive(odometry->mutex);
+	return isFound;
+}
+
+bool odometryHasReached(Odometry* odometry, unsigned long time) {
+	if (!odometry) {
+		logError("odometryHasReached", "odometry NULL");
+		return false;
+	}
+	mutexTake(odometry->mutex, 20);
+
+	const unsigned long count = odometry->sampleCount;
+	const bool hasReached = count != odometry->historyStart
+			&& (long) (odometry->history[(count - 1) % ODOMETRY_HISTORY].time - time) >= 0;
+
+	mutexGive(odometry->mutex);
+	return hasReached;
+}
+
+void odometryShiftPose(Odometry* odometry, double dx, double dy) {
+	if (!odometry) {
+		logError("odometryShiftPose", "odometry NULL");
+		return;
+	}
+	mutexTake(odometry->mutex, 20);
+
+	odometry->pose.x += dx;
+	odometry->pose.y += dy;
+	for (unsigned int i = 0; i < ODOMETRY_HISTORY; i++) {
+		odometry->history[i].pose.x += dx;
+		odometry->history[i].pose.y += dy;
+	}
+
+	mutexGive(odometry->mutex);
+}
+
+double odometryVelocity(const Odometry* odometry) {
+	if (!odometry) {
+		logError("odometryVelocity", "odometry NULL");
+		return 0.0;
+	}
+	return (odometry->velocityL + odometry->velocityR) / 2.0;
+}
+
+double odometryYawRate(const Odometry* odometry) {
+	if (!odometry) {
+		logError("odometryYawRate", "odometry NULL");
+		return 0.0;
+	}
+	if (!odometry->xsens) {
+		return (odometry->velocityR - odometry->velocityL) / odometry->chassisWidth;
+	}
+	struct XsensVex* xsens = odometry->xsens;
+	mutexTake(xsens->lastPacket.mutex, 5);
+	const double rate = xsens->lastPacket.XDI_RateOfTurn[2] - xsens->heading_bias[2];
+	mutexGive(xsens->lastPacket.mutex);
+	return rate;
+}
+
+unsigned long odometrySampleCount(const Odometry* odometry) {
+	if (!odometry) {
+		logError("odometrySampleCount", "odometry NULL");
+		return 0;
+	}
+	return odometry->sampleCount;
+}
+
+bool odometryWaitForSamples(Odometry* odometry, unsigned long* lastSample, unsigned int n,
+		unsigned long timeout) {
+	if (!odometry) {
+		logError("odometryWaitForSamples", "odometry NULL");
+		return false;
+	}
+	if (!lastSample) {
+		logError("odometryWaitForSamples", "lastSample NULL");
+		return false;
+	}
+	const unsigned long target = *lastSample + n;
+	const unsigned long start = millis();
+
+	while ((long) (odometry->sampleCount - target) < 0) {
+		const unsigned long elapsed = millis() - start;
+		if (elapsed >= timeout) {
+			return false;
+		}
+		semaphoreTake(odometry->sampleSemaphore, timeout - elapsed);
+	}
+	const unsigned long sampleCount = odometry->sampleCount;
+	*lastSample = (sampleCount - target >= n) ? sampleCount : target;
+	return true;
+}
+
 void odometryUseXsens(Odometry* odometry) {
 	odometry->useXsensNext = true;
 }
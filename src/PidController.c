@@ -29,6 +29,24 @@ double pidControllerComputeOutput(PidController* pidController, double error, un
 	return pidController->output;
 }
 
+double pidControllerComputeOutputWithRate(PidController* pidController, double error, double rate,
+		unsigned long t) {
+	if (!pidController) {
+		logError("pidControllerComputeOutputWithRate", "pidController NULL");
+		return NAN;
+	}
+	const unsigned long dt = (pidController->t == ULONG_MAX) ? 0 : (t - pidController->t);
+
+	pidController->integral += error * dt;
+
+	pidController->output = pidController->Kp * error + pidController->Ki * pidController->integral
+			- pidController->Kd * rate;
+	pidController->t = t;
+	pidController->error = error;
+
+	return pidController->output;
+}
+
 double pidControllerOutput(const PidController* pidController) {
 	if (!pidController) {
 		logError("pidControllerOutput", "pidController NULL");
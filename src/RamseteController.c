@@ -0,0 +1,57 @@
+#include "RamseteController.h"
+
+#include "log.h"
+#include "Pose.h"
+#include "Trajectory.h"
+#include "util.h"
+
+#include <math.h>
+
+RamseteController ramseteControllerCreate(double b, double zeta) {
+	return (RamseteController) {.b = b, .zeta = zeta, .velocity = 0.0, .angularVelocity = 0.0};
+}
+
+static double sinc(double x) {
+	return (fabs(x) < 0.000001) ? (1.0 - x * x / 6.0) : (sin(x) / x);
+}
+
+void ramseteControllerComputeOutput(RamseteController* ramseteController, Pose pose,
+		TrajectoryPoint reference) {
+	if (!ramseteController) {
+		logError("ramseteControllerComputeOutput", "ramseteController NULL");
+		return;
+	}
+	const double dx = reference.pose.x - pose.x;
+	const double dy = reference.pose.y - pose.y;
+	const double cosTheta = cos(pose.theta);
+	const double sinTheta = sin(pose.theta);
+
+	// Error in the robot's frame.
+	const double errorX = cosTheta * dx + sinTheta * dy;
+	const double errorY = -sinTheta * dx + cosTheta * dy;
+	const double errorTheta = boundAngleNegPiToPi(reference.pose.theta - pose.theta);
+
+	const double v = reference.velocity;
+	const double w = reference.angularVelocity;
+	const double k = 2.0 * ramseteController->zeta * sqrt(w * w + ramseteController->b * v * v);
+
+	ramseteController->velocity = v * cos(errorTheta) + k * errorX;
+	ramseteController->angularVelocity = w + k * errorTheta
+			+ ramseteController->b * v * sinc(errorTheta) * errorY;
+}
+
+double ramseteControllerVelocity(const RamseteController* ramseteController) {
+	if (!ramseteController) {
+		logError("ramseteControllerVelocity", "ramseteController NULL");
+		return 0.0;
+	}
+	return ramseteController->velocity;
+}
+
+double ramseteControllerAngularVelocity(const RamseteController* ramseteController) {
+	if (!ramseteController) {
+		logError("ramseteControllerAngularVelocity", "ramseteController NULL");
+		return 0.0;
+	}
+	return ramseteController->angularVelocity;
+}
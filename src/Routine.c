@@ -0,0 +1,305 @@
+#include "Routine.h"
+
+#include "API.h"
+#include "globals.h"
+#include "log.h"
+#include "Navigator.h"
+#include "util.h"
+
+#define ROUTINE_HEADER_LENGTH 6
+
+// Number of argument words of each opcode.
+static const unsigned char kRoutineArgCount[RoutineOpCount] = {
+	[RoutineOpEnd] = 0,
+	[RoutineOpDrive] = 4,
+	[RoutineOpDriveUntil] = 5,
+	[RoutineOpTurn] = 3,
+	[RoutineOpDriveToPoint] = 4,
+	[RoutineOpTurnToPoint] = 4,
+	[RoutineOpDriveForTime] = 3,
+	[RoutineOpWait] = 1,
+	[RoutineOpUntilTarget] = 1,
+	[RoutineOpTurnController] = 1,
+	[RoutineOpOffset] = 1,
+	[RoutineOpMogo] = 1,
+	[RoutineOpLift] = 1,
+	[RoutineOpIntake] = 1,
+	[RoutineOpWaitMogo] = 0,
+	[RoutineOpWaitLift] = 0,
+	[RoutineOpDigital] = 2,
+};
+
+static int routineWord(const unsigned char* code) {
+	return (short) (code[0] | (code[1] << 8));
+}
+
+static bool routineCheck(const Routine* routine) {
+	unsigned int pc = 0;
+	while (pc < routine->length) {
+		const unsigned char op = routine->code[pc];
+		if (op >= RoutineOpCount) {
+			logError("routineCheck", "unknown opcode");
+			return false;
+		}
+		pc += 1U + 2U * kRoutineArgCount[op];
+	}
+	if (pc != routine->length) {
+		logError("routineCheck", "truncated instruction");
+		return false;
+	}
+	return true;
+}
+
+// Reads count bytes from stream. With a timeout, only reads what fcount reports as available so
+// it gives up timeout ms after start instead of blocking; 0 reads with a blocking fread.
+static bool routineReadBytes(PROS_FILE* stream, unsigned char* buffer, unsigned int count,
+		unsigned long start, unsigned long timeout) {
+	if (timeout == 0) {
+		return fread(buffer, 1, count, stream) == count;
+	}
+	unsigned int read = 0;
+	while (read < count) {
+		const int available = fcount(stream);
+		if (available > 0) {
+			const unsigned int chunk = ((unsigned int) available < count - read)
+					? (unsigned int) available : count - read;
+			read += (unsigned int) fread(&buffer[read], 1, chunk, stream);
+		} else if (millis() - start >= timeout) {
+			return false;
+		} else {
+			delay(5);
+		}
+	}
+	return true;
+}
+
+// Reads the header and code from stream, returning false if either is bad or they don't arrive
+// within timeout ms (0 for no timeout).
+static bool routineRead(Routine* routine, PROS_FILE* stream, unsigned long timeout) {
+	const unsigned long start = millis();
+	unsigned char header[ROUTINE_HEADER_LENGTH];
+	routine->length = 0;
+	if (!routineReadBytes(stream, header, ROUTINE_HEADER_LENGTH, start, timeout)) {
+		logError("routineRead", "no header");
+		return false;
+	}
+	if (header[0] != 'R' || header[1] != 'T') {
+		logError("routineRead", "bad header");
+		return false;
+	}
+	if (header[2] != ROUTINE_VERSION) {
+		logError("routineRead", "unsupported version");
+		return false;
+	}
+	const unsigned int length = (unsigned int) (header[4] | (header[5] << 8));
+	if (length > ROUTINE_MAX_LENGTH) {
+		logError("routineRead", "routine too long");
+		return false;
+	}
+	if (!routineReadBytes(stream, routine->code, length, start, timeout)) {
+		logError("routineRead", "routine truncated");
+		return false;
+	}
+	routine->length = length;
+	if (!routineCheck(routine)) {
+		routine->length = 0;
+		return false;
+	}
+	return true;
+}
+
+bool routineLoad(Routine* routine, const char* file) {
+	if (!routine) {
+		logError("routineLoad", "routine NULL");
+		return false;
+	}
+	routine->length = 0;
+	PROS_FILE* stream = fopen(file, "r");
+	if (!stream) {
+		logError("routineLoad", "file not found");
+		return false;
+	}
+	const bool loaded = routineRead(routine, stream, 0);
+	fclose(stream);
+	return loaded;
+}
+
+bool routineReceive(Routine* routine, PROS_FILE* stream, const char* file,
+		unsigned long timeout) {
+	if (!routine) {
+		logError("routineReceive", "routine NULL");
+		return false;
+	}
+	if (!routineRead(routine, stream, timeout)) {
+		return false;
+	}
+	PROS_FILE* out = fopen(file, "w");
+	if (!out) {
+		logError("routineReceive", "file not writable");
+		return false;
+	}
+	const unsigned char header[ROUTINE_HEADER_LENGTH] = {'R', 'T', ROUTINE_VERSION, 0,
+			(unsigned char) (routine->length & 0xFF), (unsigned char) (routine->length >> 8)};
+	fwrite(header, 1, ROUTINE_HEADER_LENGTH, out);
+	fwrite(routine->code, 1, routine->length, out);
+	fclose(out);
+	return true;
+}
+
+static void routineMogo(int state) {
+	switch ((MogoState) state) {
+	case MogoUp:
+		mogoUp();
+		break;
+	case MogoDown:
+		mogoDown();
+		break;
+	case MogoDownSlow:
+		mogoDownSlow();
+		break;
+	case MogoHoldUp:
+		mogoHoldUp();
+		break;
+	default:
+		logError("routineMogo", "unknown state");
+	}
+}
+
+static void routineLift(int state) {
+	switch ((LiftState) state) {
+	case LiftUp:
+		liftUp();
+		break;
+	case LiftDown:
+		liftDown();
+		break;
+	case LiftMid:
+		liftMid();
+		break;
+	case LiftLoads:
+		liftLoads();
+		break;
+	case LiftPickupLoads:
+		liftPickupLoads();
+		break;
+	default:
+		logError("routineLift", "unknown state");
+	}
+}
+
+static void routineIntake(int state) {
+	switch ((IntakeState) state) {
+	case IntakeIn:
+		intakeIn();
+		break;
+	case IntakeOut:
+		intakeOut();
+		break;
+	case IntakeFullIn:
+		intakeFullIn();
+		break;
+	case IntakeNone:
+		intakeNone();
+		break;
+	default:
+		logError("routineIntake", "unknown state");
+	}
+}
+
+void routineRun(const Routine* routine, Navigator* navigator, double offset,
+		const PidController* turnControllers, unsigned int turnControllerCount) {
+	if (!routine) {
+		logError("routineRun", "routine NULL");
+		return;
+	}
+	if (!navigator) {
+		logError("routineRun", "navigator NULL");
+		return;
+	}
+	unsigned int pc = 0;
+	while (pc < routine->length) {
+		const unsigned char op = routine->code[pc];
+		if (op >= RoutineOpCount) {
+			logError("routineRun", "unknown opcode");
+			return;
+		}
+		const unsigned char* args = &routine->code[pc + 1];
+		int arg[5] = {0};
+		for (unsigned int i = 0; i < kRoutineArgCount[op]; i++) {
+			arg[i] = routineWord(&args[2 * i]);
+		}
+		pc += 1U + 2U * kRoutineArgCount[op];
+
+		switch ((RoutineOp) op) {
+		case RoutineOpEnd:
+			return;
+		case RoutineOpDrive:
+			navigatorDriveToDistance(navigator, (double) arg[0] / ROUTINE_DISTANCE_SCALE,
+					toRadians((double) arg[1] / ROUTINE_ANGLE_SCALE + offset),
+					(double) arg[2] / ROUTINE_POWER_SCALE, (double) arg[3] / ROUTINE_POWER_SCALE);
+			break;
+		case RoutineOpDriveUntil:
+			navigatorDriveToDistanceUntil(navigator, (double) arg[0] / ROUTINE_DISTANCE_SCALE,
+					toRadians((double) arg[1] / ROUTINE_ANGLE_SCALE + offset),
+					(double) arg[2] / ROUTINE_POWER_SCALE, (double) arg[3] / ROUTINE_POWER_SCALE,
+					arg[4]);
+			break;
+		case RoutineOpTurn:
+			navigatorTurnToAngle(navigator,
+					toRadians((double) arg[0] / ROUTINE_ANGLE_SCALE + offset),
+					(double) arg[1] / ROUTINE_POWER_SCALE, (double) arg[2] / ROUTINE_POWER_SCALE);
+			break;
+		case RoutineOpDriveToPoint:
+			navigatorDriveToPoint(navigator, (Pose) {.x = (double) arg[0] / ROUTINE_DISTANCE_SCALE,
+					.y = (double) arg[1] / ROUTINE_DISTANCE_SCALE},
+					(double) arg[2] / ROUTINE_POWER_SCALE, (double) arg[3] / ROUTINE_POWER_SCALE);
+			break;
+		case RoutineOpTurnToPoint:
+			navigatorTurnToPoint(navigator, (Pose) {.x = (double) arg[0] / ROUTINE_DISTANCE_SCALE,
+					.y = (double) arg[1] / ROUTINE_DISTANCE_SCALE},
+					(double) arg[2] / ROUTINE_POWER_SCALE, (double) arg[3] / ROUTINE_POWER_SCALE);
+			break;
+		case RoutineOpDriveForTime:
+			navigatorDriveForTime(navigator, (double) arg[0] / ROUTINE_POWER_SCALE,
+					(double) arg[1] / ROUTINE_POWER_SCALE, (unsigned short) arg[2]);
+			break;
+		case RoutineOpWait:
+			delay((unsigned short) arg[0]);
+			break;
+		case RoutineOpUntilTarget:
+			navigator->until_target = arg[0];
+			break;
+		case RoutineOpTurnController:
+			if (arg[0] < 0 || (unsigned int) arg[0] >= turnControllerCount) {
+				logError("routineRun", "turn controller out of range");
+				break;
+			}
+			navigator->turnController = turnControllers[arg[0]];
+			break;
+		case RoutineOpOffset:
+			offset = (double) arg[0] / ROUTINE_ANGLE_SCALE;
+			break;
+		case RoutineOpMogo:
+			routineMogo(arg[0]);
+			break;
+		case RoutineOpLift:
+			routineLift(arg[0]);
+			break;
+		case RoutineOpIntake:
+			routineIntake(arg[0]);
+			break;
+		case RoutineOpWaitMogo:
+			waitUntilMogo();
+			break;
+		case RoutineOpWaitLift:
+			waitUntilLift();
+			break;
+		case RoutineOpDigital:
+			digitalWrite((unsigned char) arg[0], arg[1] ? HIGH : LOW);
+			break;
+		default:
+			logError("routineRun", "unknown opcode");
+			return;
+		}
+	}
+}
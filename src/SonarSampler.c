@@ -0,0 +1,139 @@
+#include "SonarSampler.h"
+
+#include "API.h"
+#include "log.h"
+
+#include <stdlib.h>
+
+// Echo pulse width in us per cm of distance.
+static const unsigned long kMicrosPerCm = 58;
+static const unsigned long kPingMicros = 20;
+
+static SonarChannel channels[SONAR_SAMPLER_CHANNELS];
+static unsigned int channelCount = 0;
+// The channel whose ping is in flight.
+static unsigned int active = 0;
+static bool isPinging = false;
+
+static SonarChannel* sonarSamplerChannel(int sonar) {
+	if (sonar < 0 || (unsigned int) sonar >= channelCount) {
+		logError("sonarSamplerChannel", "sonar out of range");
+		return NULL;
+	}
+	return &channels[sonar];
+}
+
+static void sonarSamplerInterrupt(unsigned char pin) {
+	const unsigned long t = micros();
+	for (unsigned int i = 0; i < channelCount; i++) {
+		SonarChannel* channel = &channels[i];
+		if (channel->echoPort != pin) {
+			continue;
+		}
+		if (digitalRead(pin)) {
+			channel->echoStart = t;
+		} else if (channel->echoStart != 0) {
+			channel->echoEnd = t;
+			channel->isEchoDone = true;
+		}
+		return;
+	}
+}
+
+int sonarSamplerAdd(unsigned char echoPort, unsigned char pingPort) {
+	if (channelCount >= SONAR_SAMPLER_CHANNELS) {
+		logError("sonarSamplerAdd", "no channels left");
+		return -1;
+	}
+	SonarChannel* channel = &channels[channelCount];
+	*channel = (SonarChannel) {.echoPort = echoPort, .pingPort = pingPort, .echoStart = 0,
+			.echoEnd = 0, .isEchoDone = false, .historyCount = 0, .echoTime = 0,
+			.reading = {.time = 0, .raw = -1, .distance = -1, .isOutlier = false},
+			.readingCount = 0};
+	pinMode(pingPort, OUTPUT);
+	digitalWrite(pingPort, LOW);
+	pinMode(echoPort, INPUT);
+	ioSetInterrupt(echoPort, INTERRUPT_EDGE_BOTH, sonarSamplerInterrupt);
+	return (int) channelCount++;
+}
+
+int sonarSamplerDistance(int sonar) {
+	const SonarChannel* channel = sonarSamplerChannel(sonar);
+	if (!channel || channel->historyCount == 0
+			|| (micros() - channel->echoTime) / 1000 > SONAR_SAMPLER_STALE) {
+		return -1;
+	}
+	return channel->reading.distance;
+}
+
+bool sonarSamplerReading(int sonar, SonarReading* reading) {
+	const SonarChannel* channel = sonarSamplerChannel(sonar);
+	if (!channel || !reading) {
+		return false;
+	}
+	const unsigned int count = channel->readingCount;
+	if (count == 0) {
+		return false;
+	}
+	*reading = channel->reading;
+	// The task may have replaced the reading while it was copied.
+	return channel->readingCount == count;
+}
+
+static int compareInts(const void* a, const void* b) {
+	return *(const int*) a - *(const int*) b;
+}
+
+static int sonarSamplerMedian(const SonarChannel* channel) {
+	const unsigned int count = (channel->historyCount < SONAR_SAMPLER_HISTORY)
+			? channel->historyCount : SONAR_SAMPLER_HISTORY;
+	int sorted[SONAR_SAMPLER_HISTORY];
+	for (unsigned int i = 0; i < count; i++) {
+		sorted[i] = channel->history[i];
+	}
+	qsort(sorted, count, sizeof(sorted[0]), compareInts);
+	return sorted[count / 2];
+}
+
+// Turns the finished ping into a reading.
+static void sonarSamplerFinish(SonarChannel* channel, unsigned long pingTime) {
+	SonarReading reading = channel->reading;
+	reading.time = pingTime;
+	reading.raw = channel->isEchoDone
+			? (int) ((channel->echoEnd - channel->echoStart) / kMicrosPerCm) : -1;
+	reading.isOutlier = false;
+	if (reading.raw > 0) {
+		// Echoes from before a gap may have come off something that has since moved.
+		if (channel->historyCount > 0
+				&& (pingTime - channel->echoTime) / 1000 > SONAR_SAMPLER_STALE) {
+			channel->historyCount = 0;
+		}
+		channel->history[channel->historyCount % SONAR_SAMPLER_HISTORY] = reading.raw;
+		channel->historyCount++;
+		channel->echoTime = pingTime;
+		reading.distance = sonarSamplerMedian(channel);
+		reading.isOutlier = abs(reading.raw - reading.distance) > SONAR_SAMPLER_OUTLIER;
+	}
+	channel->reading = reading;
+	channel->readingCount++;
+}
+
+void sonarSamplerTask() {
+	static unsigned long pingTime = 0;
+	if (channelCount == 0) {
+		return;
+	}
+	if (isPinging) {
+		sonarSamplerFinish(&channels[active], pingTime);
+		active = (active + 1) % channelCount;
+	}
+
+	SonarChannel* channel = &channels[active];
+	channel->echoStart = 0;
+	channel->isEchoDone = false;
+	pingTime = micros();
+	digitalWrite(channel->pingPort, HIGH);
+	delayMicroseconds(kPingMicros);
+	digitalWrite(channel->pingPort, LOW);
+	isPinging = true;
+}
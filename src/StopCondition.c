@@ -0,0 +1,105 @@
+#include "StopCondition.h"
+
+#include "API.h"
+#include "LineSensor.h"
+#include "log.h"
+#include "SonarSampler.h"
+
+#include <limits.h>
+
+StopCondition stopConditionCreate(StopConditionRead read, const void* source, int low, int high,
+		int hysteresis, unsigned long samplePeriod, unsigned int debounce) {
+	if (!read) {
+		logError("stopConditionCreate", "read NULL");
+		return (StopCondition) {};
+	}
+	return (StopCondition) {.read = read, .source = source, .low = low, .high = high,
+			.hysteresis = hysteresis, .samplePeriod = samplePeriod,
+			.debounce = (debounce == 0) ? 1 : debounce, .value = -1, .sampleTime = 0, .count = 0,
+			.isInside = false};
+}
+
+StopCondition stopConditionLine(const LineSensor* lineSensor, unsigned int debounce) {
+	if (!lineSensor) {
+		logError("stopConditionLine", "lineSensor NULL");
+		return (StopCondition) {};
+	}
+	return stopConditionCreate(stopConditionReadAnalog, lineSensor, 0, lineSensor->toggle_level - 1,
+			LINE_SENSOR_HYSTERESIS, 0, debounce);
+}
+
+StopCondition stopConditionNoLine(const LineSensor* lineSensor, unsigned int debounce) {
+	if (!lineSensor) {
+		logError("stopConditionNoLine", "lineSensor NULL");
+		return (StopCondition) {};
+	}
+	return stopConditionCreate(stopConditionReadAnalog, lineSensor, lineSensor->toggle_level,
+			INT_MAX, LINE_SENSOR_HYSTERESIS, 0, debounce);
+}
+
+StopCondition stopConditionSonar(const int* sonar, int low, int high, unsigned int debounce) {
+	if (!sonar) {
+		logError("stopConditionSonar", "sonar NULL");
+		return (StopCondition) {};
+	}
+	// Sample once per ping so debounce counts distinct readings.
+	return stopConditionCreate(stopConditionReadSonar, sonar, low, high, 0,
+			SONAR_SAMPLER_SLOT * SONAR_SAMPLER_CHANNELS, debounce);
+}
+
+void stopConditionReset(StopCondition* stopCondition) {
+	if (!stopCondition) {
+		logError("stopConditionReset", "stopCondition NULL");
+		return;
+	}
+	stopCondition->value = -1;
+	stopCondition->sampleTime = 0;
+	stopCondition->count = 0;
+	stopCondition->isInside = false;
+}
+
+static void stopConditionSample(StopCondition* stopCondition, unsigned long now) {
+	if (stopCondition->sampleTime != 0
+			&& (now - stopCondition->sampleTime) < stopCondition->samplePeriod) {
+		return;
+	}
+	stopCondition->sampleTime = now;
+
+	const int value = stopCondition->read(stopCondition->source);
+	if (value < 0) {
+		return;
+	}
+	stopCondition->value = value;
+
+	const int margin = stopCondition->isInside ? stopCondition->hysteresis : 0;
+	const bool isInside = value >= stopCondition->low - margin
+			&& value <= stopCondition->high + margin;
+	stopCondition->isInside = isInside;
+	stopCondition->count = isInside ? (stopCondition->count + 1) : 0;
+}
+
+int stopConditionsUpdate(StopCondition* stopConditions, unsigned int count, unsigned long now) {
+	if (!stopConditions) {
+		return -1;
+	}
+	int tripped = -1;
+	for (unsigned int i = 0; i < count; i++) {
+		StopCondition* stopCondition = &stopConditions[i];
+		if (!stopCondition->read) {
+			continue;
+		}
+		stopConditionSample(stopCondition, now);
+		if (tripped < 0 && stopCondition->count >= stopCondition->debounce) {
+			tripped = (int) i;
+		}
+	}
+	return tripped;
+}
+
+int stopConditionReadAnalog(const void* lineSensor) {
+	return lineSensorValue((const LineSensor*) lineSensor);
+}
+
+int stopConditionReadSonar(const void* sonar) {
+	return sonarSamplerDistance(*(const int*) sonar);
+}
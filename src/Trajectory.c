@@ -0,0 +1,57 @@
+#include "Trajectory.h"
+
+#include "log.h"
+#include "Pose.h"
+#include "util.h"
+
+Trajectory trajectoryCreate(const TrajectoryPoint* points, unsigned int length) {
+	if (!points) {
+		logError("trajectoryCreate", "points NULL");
+		return (Trajectory) {};
+	}
+	return (Trajectory) {.points = points, .length = length};
+}
+
+unsigned long trajectoryDuration(const Trajectory* trajectory) {
+	if (!trajectory) {
+		logError("trajectoryDuration", "trajectory NULL");
+		return 0;
+	}
+	if (trajectory->length == 0) {
+		return 0;
+	}
+	return trajectory->points[trajectory->length - 1].time;
+}
+
+TrajectoryPoint trajectorySample(const Trajectory* trajectory, unsigned long time) {
+	if (!trajectory) {
+		logError("trajectorySample", "trajectory NULL");
+		return (TrajectoryPoint) {};
+	}
+	if (trajectory->length == 0) {
+		return (TrajectoryPoint) {};
+	}
+	const TrajectoryPoint* points = trajectory->points;
+	if (time <= points[0].time) {
+		return points[0];
+	}
+	const unsigned int last = trajectory->length - 1;
+	if (time >= points[last].time) {
+		return points[last];
+	}
+	unsigned int i = 1;
+	while (points[i].time < time) {
+		i++;
+	}
+	const TrajectoryPoint* a = &points[i - 1];
+	const TrajectoryPoint* b = &points[i];
+	const double s = (double) (time - a->time) / (double) (b->time - a->time);
+
+	return (TrajectoryPoint) {.time = time,
+			.pose = {.x = a->pose.x + (b->pose.x - a->pose.x) * s,
+					.y = a->pose.y + (b->pose.y - a->pose.y) * s,
+					.theta = boundAngleNegPiToPi(a->pose.theta
+							+ boundAngleNegPiToPi(b->pose.theta - a->pose.theta) * s)},
+			.velocity = a->velocity + (b->velocity - a->velocity) * s,
+			.angularVelocity = a->angularVelocity + (b->angularVelocity - a->angularVelocity) * s};
+}
@@ -34,9 +34,15 @@
  * so, the robot will await a switch to another mode or disable/enable cycle.
  */
 void autonomous() {
-	taskRunLoop(odometryTask, 2);
-	taskRunLoop(debugTask, 100);
-	taskRunLoop(mogoTask, 20);
+	executiveStart(&executive);
+	executiveEnable(&executive, JobAnalog, 0);
+	executiveEnable(&executive, JobOdometry, 2);
+	// JobLandmarks stays off until the landmark map and sensor offsets in init.c are measured.
+	executiveEnable(&executive, JobSonar, 0);
+	// Run Navigator loops on every 5th pose, 10 ms.
+	navigator.controlDivider = 5;
+	executiveEnable(&executive, JobDebug, 0);
+	executiveEnable(&executive, JobMogo, 0);
 
 	/*mogoDown();
 	intakeIn();
@@ -49,11 +55,11 @@ void autonomous() {
 	mogoUp();
 	delay(1500);
 	liftDown();
-	navigatorDriveToPointUntil(&navigator, (Pose) {.x = 20, .y = 0, .theta = 0}, -0.5, -0.5, UNTIL_LEFT_LINE);
+	navigatorDriveToPointUntil(&navigator, (Pose) {.x = 20, .y = 0, .theta = 0}, -0.5, 0.5, UNTIL_LEFT_LINE);
 	odometrySetPose(&odometry, (Pose) {.x = 30, .y = odometry.pose.y, .theta = odometry.pose.theta});
 	intakeOut();
 	liftMid();
-	navigatorDriveToPoint(&navigator, (Pose) {.x = 12, .y = 0, .theta = 0}, -0.5, 0.1);
+	navigatorDriveToPoint(&navigator, (Pose) {.x = 12, .y = 0, .theta = 0}, -0.5, -0.1);
 	delay(250);
 	intakeNone();
 	navigatorTurnToPoint(&navigator, (Pose) {.x = 0, .y = 24, .theta = 0}, 0.8, 0.8);
@@ -66,7 +72,7 @@ void autonomous() {
 	driveSetPowerAll(&drive, 0);
 	mogoDown();
 	delay(500);
-	navigatorDriveToPoint(&navigator, (Pose) {.x = 68, .y = 31, .theta = 0}, -0.5, 0.05);
+	navigatorDriveToPoint(&navigator, (Pose) {.x = 68, .y = 31, .theta = 0}, -0.5, -0.05);
 	navigatorTurnToPoint(&navigator, (Pose) {.x = 50, .y = 30, .theta = 0}, 0.8, -0.1);
 	navigatorDriveToPoint(&navigator, (Pose) {.x = 50, .y = 30, .theta = 0}, 0.5, -0.05);
 	mogoUp();
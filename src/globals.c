@@ -1,19 +1,64 @@
 #include "globals.h"
 
+#include "AnalogSampler.h"
 #include "asciitof.h"
 #include "Motor.h"
 #include "Encoder1Wire.h"
 #include "main.h"
 #include "Odometry.h"
+#include "SonarSampler.h"
+#include "util.h"
 
 #include <math.h>
 
 const unsigned char imeLift = 0;
 
+// Analog sampling runs every 1 ms, the roller encoder every 2 ms and odometry every 5 ms (2 ms
+// in autonomous); landmarks, mogo and intake every 10 ms, lift every 20 ms, sonar every
+// SONAR_SAMPLER_SLOT ms and debug every 100 ms. Phases spread the 10 ms and slower jobs over
+// different ticks.
+ExecutiveJob executiveJobs[JobCount] = {
+	[JobOdometry] = {.name = "odometry", .function = odometryTask, .period = 5, .priority = 0},
+	[JobAnalog] = {.name = "analog", .function = analogSamplerTask, .period = 1, .priority = 1},
+	[JobEncoderAnalog] = {.name = "encoderAnalog", .function = encoderAnalogTask, .period = 2,
+			.phase = 1, .priority = 1},
+	[JobLandmarks] = {.name = "landmarks", .function = landmarkTask, .period = 10, .phase = 5,
+			.priority = 2},
+	[JobSonar] = {.name = "sonar", .function = sonarSamplerTask, .period = SONAR_SAMPLER_SLOT,
+			.phase = 9, .priority = 2},
+	[JobLift] = {.name = "lift", .function = liftTask, .period = 20, .phase = 3, .priority = 2},
+	[JobMogo] = {.name = "mogo", .function = mogoTask, .period = 10, .phase = 7, .priority = 3},
+	[JobIntake] = {.name = "intake", .function = intakeTask, .period = 10, .phase = 11,
+			.priority = 4},
+	[JobDebug] = {.name = "debug", .function = debugTask, .period = 100, .phase = 13,
+			.priority = 5},
+};
+
 void compControlTask() {
 	int c = fgetc(stdin);
 	if (c == 'a') {
 		autonomous();
+	} else if (c == 'c') {
+		identifyCoast(false);
+	} else if (c == 't') {
+		identifyCoast(true);
+	}
+}
+
+void identifyCoast(bool isTurn) {
+	const double powers[] = {0.3, 0.5, 0.7, 0.9, 1.0};
+	CoastSample samples[5];
+
+	for (int i = 0; i < 5; i++) {
+		samples[i] = navigatorMeasureCoast(&navigator, isTurn, powers[i], isTurn ? 400 : 600);
+		delay(500);
+	}
+	CoastModel model = coastModelFit(samples, 5);
+	printf("coastModel,%s,%f,%f\n", isTurn ? "turn" : "drive", model.linear, model.quadratic);
+	if (isTurn) {
+		navigator.turnCoast = model;
+	} else {
+		navigator.driveCoast = model;
 	}
 }
 
@@ -21,6 +66,10 @@ void odometryTask() {
 	odometryComputePose(&odometry);
 }
 
+void landmarkTask() {
+	landmarkCorrectorUpdate(&landmarkCorrector);
+}
+
 void debugTask() {
 	//printf("(%.3f x, %.3f y, %f theta)\n", odometry.pose.x, odometry.pose.y, odometry.pose.theta);
 	//printf("xsens yaw: %.3f\n", xsens_get_yaw(&xsens));
@@ -58,87 +107,212 @@ void pidTuneTask(void *p) {
 	}
 }
 
-MogoState mogoState = MogoUp;
-bool mogoDone = true;
+static void mechanismSignal() {
+	if (mechanismSemaphore) {
+		semaphoreGive(mechanismSemaphore);
+	}
+}
+
+static bool mechanismsAreDone(unsigned int mechanisms, bool all) {
+	unsigned int done = 0;
+	if (isMogoDone()) {
+		done |= MechanismMogo;
+	}
+	if (isLiftDone()) {
+		done |= MechanismLift;
+	}
+	if (isIntakeDone()) {
+		done |= MechanismIntake;
+	}
+	done &= mechanisms;
+	return all ? (done == mechanisms) : (done != 0);
+}
+
+WaitStatus waitForMechanisms(unsigned int mechanisms, bool all, unsigned long timeout) {
+	if (mechanisms == 0) {
+		return WaitDone;
+	}
+	const unsigned long start = millis();
+	while (!mechanismsAreDone(mechanisms, all)) {
+		if (timeout == MAX_DELAY) {
+			semaphoreTake(mechanismSemaphore, MAX_DELAY);
+			continue;
+		}
+		const unsigned long elapsed = millis() - start;
+		if (elapsed >= timeout) {
+			return WaitTimedOut;
+		}
+		semaphoreTake(mechanismSemaphore, timeout - elapsed);
+	}
+	return WaitDone;
+}
+
+/**
+ * Mechanism commands are written by the routine's task and picked up by the mechanism's task
+ * on its next tick. A command bumps the mechanism's command count after setting its state; a
+ * task marks the command done by storing the count it acted on, so a command issued mid-tick
+ * never reads as done for the previous one. Tasks never block: timed steps are states that
+ * end once their time has passed, and a new command preempts whatever is running.
+ */
+
+// A timed power step of a mogo command. It ends early once the mogo reaches end, the share of
+// the travel from up (0) to down (1); time is only a timeout.
+typedef struct MogoPhase {
+	double power;
+	unsigned long time;
+	double end;
+} MogoPhase;
+
+// Power steps of a mogo command, then the PWM that holds the mogo in place.
+typedef struct MogoAction {
+	const MogoPhase* phases;
+	unsigned int count;
+	int holdPwm;
+} MogoAction;
+
+static const MogoPhase kMogoUpPhases[] = {{1.0, 1000, 0.0}};
+static const MogoPhase kMogoDownPhases[] = {{-1.0, 1000, 1.0}};
+static const MogoPhase kMogoDownSlowPhases[] = {{-1.0, 500, 0.4}, {-0.6, 700, 1.0}};
+
+static const MogoAction kMogoActions[] = {
+	[MogoUp] = {kMogoUpPhases, 1, 15},
+	[MogoDown] = {kMogoDownPhases, 1, -15},
+	[MogoDownSlow] = {kMogoDownSlowPhases, 2, -15},
+	[MogoHoldUp] = {NULL, 0, 30},
+};
+
+volatile MogoState mogoState = MogoUp;
+volatile unsigned int mogoCommandCount = 0;
+volatile unsigned int mogoDoneCount = 0;
+
+static void mogoCommand(MogoState state) {
+	mogoState = state;
+	mogoCommandCount++;
+}
 
 void mogoUp() {
-	mogoDone = false;
-	mogoState = MogoUp;
+	mogoCommand(MogoUp);
 }
 
 void mogoDown() {
-	mogoDone = false;
-	mogoState = MogoDown;
+	mogoCommand(MogoDown);
 }
 
 void mogoDownSlow() {
-	mogoDone = false;
-	mogoState = MogoDownSlow;
+	mogoCommand(MogoDownSlow);
 }
 
 void mogoHoldUp() {
-	mogoDone = true;
-	mogoState = MogoHoldUp;
+	mogoCommand(MogoHoldUp);
+}
+
+static bool mogoHasReached(const MogoPhase* phase, int position) {
+	const int travel = mogoTuning.downPosition - mogoTuning.upPosition;
+	if (travel == 0) {
+		return false;
+	}
+	const double done = (double) (position - mogoTuning.upPosition) / travel;
+	const double band = (double) mogoTuning.endBand / abs(travel);
+	return (phase->power > 0.0) ? (done <= phase->end + band) : (done >= phase->end - band);
 }
 
 void mogoTask() {
-	static MogoState lastMogoState = MogoUp;
-	if (mogoState == MogoHoldUp)
-	{
-		motorSetPwm(&motorMogo, 30);
-	}
-	else if (mogoState != lastMogoState) {
-		lastMogoState = mogoState;
-		if (mogoState == MogoUp) {
-			motorSetPower(&motorMogo, 1.0);
-			delay(1000);
-			motorSetPwm(&motorMogo, 15);
-		} else if (mogoState == MogoDown){
-			motorSetPower(&motorMogo, -1.0);
-			delay(1000);
-			motorSetPwm(&motorMogo, -15);
-		} else if (mogoState == MogoDownSlow){
-			motorSetPower(&motorMogo, -1.0);
-			delay(500);
-			motorSetPower(&motorMogo, -0.6);
-			delay(700);
-			motorSetPwm(&motorMogo, -15);
+	static MogoState runningState = MogoUp;
+	static unsigned int seenCount = 0;
+	static unsigned int phase = 1;
+	static unsigned long phaseTime = 0;
+	static int lastPosition = 0;
+	static unsigned long lastTime = 0;
+	static double speed = 0.0;
+	static unsigned long stallTimestamp = 0;
+
+	const unsigned long now = millis();
+	const unsigned int count = mogoCommandCount;
+	const MogoState state = mogoState;
+	// Repeating the running command doesn't restart it.
+	if (count != seenCount && state != runningState) {
+		runningState = state;
+		phase = 0;
+		phaseTime = now;
+		stallTimestamp = 0;
+	}
+	seenCount = count;
+
+	const bool hasSensor = mogoTuning.potPort != 0;
+	const int position = hasSensor ? analogSamplerValue(mogoTuning.potPort) : 0;
+	if (hasSensor && lastTime != 0 && now != lastTime) {
+		speed += 0.5 * ((double) (position - lastPosition) * 1000.0 / (double) (now - lastTime)
+				- speed);
+	}
+	lastPosition = position;
+	lastTime = now;
+
+	const MogoAction* action = &kMogoActions[runningState];
+	while (phase < action->count && (now - phaseTime >= action->phases[phase].time
+			|| (hasSensor && mogoHasReached(&action->phases[phase], position)))) {
+		phaseTime = now;
+		phase++;
+	}
+	// A mogo that stops moving under power has hit the end of its travel; one just starting a
+	// phase is still spinning up.
+	if (phase < action->count && hasSensor && now - phaseTime >= mogoTuning.stallGrace
+			&& fabs(speed) < mogoTuning.stallSpeed) {
+		if (stallTimestamp == 0) {
+			stallTimestamp = now;
+		} else if (now - stallTimestamp >= mogoTuning.stallTime) {
+			phase = action->count;
+		}
+	} else {
+		stallTimestamp = 0;
+	}
+
+	if (phase < action->count) {
+		motorSetPower(&motorMogo, action->phases[phase].power);
+	} else {
+		motorSetPwm(&motorMogo, action->holdPwm);
+		if (mogoDoneCount != count) {
+			mogoDoneCount = count;
+			mechanismSignal();
 		}
-		mogoDone = true;
 	}
 }
 
 void waitUntilMogo() {
-	while (!mogoDone) {
-		delay(20);
-	}
+	waitForMechanisms(MechanismMogo, true, MAX_DELAY);
 }
 
-LiftState liftState = LiftDown;
-bool liftIsDone = true;
+bool isMogoDone() {
+	return mogoDoneCount == mogoCommandCount;
+}
+
+volatile LiftState liftState = LiftDown;
+volatile unsigned int liftCommandCount = 0;
+volatile unsigned int liftSeenCount = 0;
+volatile bool liftIsAtTarget = true;
+
+static void liftCommand(LiftState state) {
+	liftState = state;
+	liftCommandCount++;
+}
 
 void liftUp() {
-	liftState = LiftUp;
+	liftCommand(LiftUp);
 }
 
 void liftDown() {
-	liftState = LiftDown;
-	liftIsDone = false;
+	liftCommand(LiftDown);
 }
 
 void liftLoads() {
-	liftState = LiftLoads;
-	liftIsDone = false;
+	liftCommand(LiftLoads);
 }
 
 void liftPickupLoads() {
-	liftState = LiftPickupLoads;
-	liftIsDone = false;
+	liftCommand(LiftPickupLoads);
 }
 
 void liftMid() {
-	liftState = LiftMid;
-	liftIsDone = false;
+	liftCommand(LiftMid);
 }
 
 int getLiftPosition() {
@@ -146,27 +320,31 @@ int getLiftPosition() {
 }
 
 void waitUntilLift() {
-	while (!liftIsDone) {
-		delay(20);
-	}
+	waitForMechanisms(MechanismLift, true, MAX_DELAY);
+}
+
+bool isLiftDone() {
+	return liftSeenCount == liftCommandCount && liftIsAtTarget;
 }
 
 void liftTask() {
+	const unsigned int count = liftCommandCount;
+	const LiftState state = liftState;
 	int liftPosition = getLiftPosition();
 	double error = 0;
 	double hold = 0;
 
-	if (liftState == LiftDown) {
+	if (state == LiftDown) {
 		error = 0 - liftPosition;
 		if (fabs(error) < 20) {
 			hold = 0.05;
 		}
-	} else if (liftState == LiftMid){
+	} else if (state == LiftMid){
 		error = -275 - liftPosition;
 		//if (abs(error) < 20) hold = 0.05;
-	} else if (liftState == LiftLoads) {
+	} else if (state == LiftLoads) {
 		error = -600 - liftPosition;
-	} else if (liftState == LiftPickupLoads) {
+	} else if (state == LiftPickupLoads) {
 		error = -900 - liftPosition;
 	} else {
 		error = -1325 - liftPosition;
@@ -175,7 +353,12 @@ void liftTask() {
 		}
 	}
 
-	liftIsDone = fabs(error) < 150;
+	const bool wasDone = isLiftDone();
+	liftIsAtTarget = fabs(error) < 150;
+	liftSeenCount = count;
+	if (!wasDone && isLiftDone()) {
+		mechanismSignal();
+	}
 
 	double pidOutput = pidControllerComputeOutput(&liftController, -error, 1);
 
@@ -191,62 +374,122 @@ int getIntakePosition() {
 	return (int) encoderAnalogCounts(encoderRoller);
 }
 
-IntakeState intakeState = IntakeNone;
+volatile IntakeState intakeState = IntakeNone;
+volatile unsigned int intakeCommandCount = 0;
+volatile unsigned int intakeDoneCount = 0;
+volatile bool intakeConeAcquired = false;
+volatile bool intakeJammed = false;
+
+static void intakeCommand(IntakeState state) {
+	intakeState = state;
+	intakeCommandCount++;
+}
 
 void intakeIn() {
-	intakeState = IntakeIn;
+	intakeCommand(IntakeIn);
+}
+
+void intakeFullIn() {
+	intakeCommand(IntakeFullIn);
 }
 
 void intakeOut() {
-	intakeState = IntakeOut;
+	intakeCommand(IntakeOut);
 }
 
 void intakeNone() {
-	intakeState = IntakeNone;
+	intakeCommand(IntakeNone);
 }
 
-/*void intakeFullIn() {
-	intakeState = IntakeFullIn;
-}*/
+bool isIntakeDone() {
+	return intakeDoneCount == intakeCommandCount;
+}
+
+bool intakeHasCone() {
+	return intakeConeAcquired;
+}
+
+bool intakeIsJammed() {
+	return intakeJammed;
+}
 
 void intakeTask() {
+	static unsigned int seenCount = 0;
+	// The intake drops to holding by itself once a cone is acquired, or stops once the rollers
+	// jam, without overwriting a newer command.
+	static IntakeState runningState = IntakeNone;
+	static bool isStopped = false;
 	static int lastPosition = 0;
-	static int velocityZeroCounter = 0;
-
-	int intakePosition = getIntakePosition();
-	int intakeVelocity = intakePosition - lastPosition;
-
-	if (intakeState == IntakeFullIn) {
-		motorSetPower(&motorRollers, 1.0);
-		//printf("IntakeFullin\n");
-	}
-	else if (intakeState == IntakeNone) {
-		motorSetPower(&motorRollers, 0.15);
-		velocityZeroCounter = 0;
-		//printf("IntakeNone\n");
-	} else if (intakeState == IntakeIn) {
-		if (abs(intakeVelocity) < 2) {
-			printf("intakeVelocity: %d\n", intakeVelocity);
-			velocityZeroCounter++;
-		} else {
-			velocityZeroCounter = 0;
+	static unsigned long lastTime = 0;
+	static double speed = 0.0;
+	static double expectedSpeed = 0.0;
+	static double power = 0.0;
+	static double shortfall = 0.0;
+
+	const unsigned int count = intakeCommandCount;
+	if (count != seenCount) {
+		seenCount = count;
+		runningState = intakeState;
+		isStopped = false;
+		shortfall = 0.0;
+		if (runningState != IntakeNone) {
+			intakeConeAcquired = false;
+			intakeJammed = false;
 		}
-		if (velocityZeroCounter > 4) {
-			//printf("QuitingIn\n");
-			motorSetPower(&motorRollers, 0.15);
-			intakeState = IntakeNone;
+	}
+
+	const unsigned long t = micros();
+	const int intakePosition = getIntakePosition();
+	if (lastTime != 0 && t != lastTime) {
+		const double dt = (double) (t - lastTime) / 1000000.0;
+		speed += 0.3 * ((intakePosition - lastPosition) / dt - speed);
+		// Speed the rollers would reach under the last tick's power if nothing loaded them.
+		expectedSpeed += fmin(dt / intakeTuning.timeConstant, 1.0)
+				* (fabs(power) * intakeTuning.maxSpeed - expectedSpeed);
+
+		const double residual = (expectedSpeed > 0.0) ? 1.0 - speed / expectedSpeed : 0.0;
+		const double threshold = (runningState == IntakeIn) ? intakeTuning.acquiredResidual
+				: intakeTuning.jamResidual;
+		shortfall = fmax(0.0, shortfall + (residual - threshold) * dt);
+	}
+	lastPosition = intakePosition;
+	lastTime = t;
+
+	// Full in holds the rollers at full power, so it never trips.
+	if ((runningState == IntakeIn || runningState == IntakeOut)
+			&& shortfall >= intakeTuning.confidence) {
+		if (runningState == IntakeIn) {
+			intakeConeAcquired = true;
 		} else {
-		//	printf("Running in");
-			motorSetPower(&motorRollers, 1.0);
+			// Holding would drive the jammed cone back in.
+			intakeJammed = true;
+			isStopped = true;
 		}
-	} else if (intakeState == IntakeOut) {
-		//printf("Running out");
-		velocityZeroCounter = 0;
-		motorSetPower(&motorRollers, -1.0);
+		runningState = IntakeNone;
+		shortfall = 0.0;
+	}
+
+	double target = 0.0;
+	if (runningState == IntakeIn) {
+		target = intakeTuning.inSpeed;
+	} else if (runningState == IntakeOut) {
+		target = -intakeTuning.outSpeed;
+	}
+
+	if (runningState == IntakeNone) {
+		power = isStopped ? 0.0 : intakeTuning.holdPower;
+	} else if (runningState == IntakeFullIn) {
+		power = 1.0;
 	} else {
-		velocityZeroCounter = 0;
+		// Feedforward from the free-running speed, plus feedback on the speed shortfall.
+		const double error = fabs(target) - speed;
+		power = clamp(fabs(target) / intakeTuning.maxSpeed + intakeTuning.Kp * error, 0.0, 1.0);
+		power = copysign(power, target);
 	}
-	//printf("IV = %d %d\n", intakeVelocity);
+	motorSetPower(&motorRollers, power);
 
-	lastPosition = intakePosition;
+	if (runningState == IntakeNone && intakeDoneCount != count) {
+		intakeDoneCount = count;
+		mechanismSignal();
+	}
 }
@@ -12,19 +12,37 @@
 
 #include "main.h"
 
+#include "AnalogSampler.h"
 #include "API.h"
 #include "Drive.h"
 #include "EncoderAnalog.h"
 #include "Encoder1Wire.h"
 #include "EncoderWheel.h"
 #include "globals.h"
+#include "Landmark.h"
 #include "Motor.h"
 #include "Navigator.h"
 #include "Odometry.h"
 #include "PidController.h"
 #include "Pose.h"
+#include "SonarSampler.h"
 #include "xsens.h"
 
+// Landmarks in the starting frame. The line is guessed from where the autonomous routine reset x
+// to 30 on the left line sensor; no bars are mapped yet. Unmeasured, so JobLandmarks is off.
+static const Landmark landmarks[] = {
+	{.type = LandmarkLine, .start = {.x = 36, .y = -72}, .end = {.x = 36, .y = 72}, .width = 2},
+};
+
+// Mounting offsets are estimates until measured on the robot.
+static LandmarkSensor landmarkSensors[] = {
+	{.port = 1, .type = LandmarkLine, .x = 6, .y = 5},
+	{.port = 2, .type = LandmarkLine, .x = 6, .y = -5},
+	{.port = 6, .type = LandmarkLine, .x = -7, .y = 0},
+	{.port = 3, .type = LandmarkBar, .x = 8, .y = 4},
+	{.port = 4, .type = LandmarkBar, .x = 8, .y = -4},
+};
+
 /*
  * Runs pre-initialization code. This function will be started in kernel mode one time while the
  * VEX Cortex is starting up. As the scheduler is still paused, most API functions will fail.
@@ -83,6 +101,17 @@ void initialize() {
 
 	mogoDetect = lineSensorCreate(5, 1000);
 
+	// No mogo potentiometer is fitted yet, so mogo moves run their timed phases. Once it is, set
+	// potPort (analog 8 is free) and measure upPosition and downPosition.
+	mogoTuning = (MogoTuning) {.potPort = 0, .upPosition = 0, .downPosition = 0, .endBand = 60,
+			.stallSpeed = 200.0, .stallTime = 150, .stallGrace = 100};
+	if (mogoTuning.potPort != 0) {
+		analogSamplerEnable(mogoTuning.potPort);
+	}
+
+	front_left_sonar = sonarSamplerAdd(11, 9);
+	front_right_sonar = sonarSamplerAdd(12, 10);
+
 	pinMode(mogo_release_tipper_port, OUTPUT);
 	pinMode(mogo_tipper_port, OUTPUT);
 
@@ -104,6 +133,9 @@ void initialize() {
 	//const Pose initialPose = poseCreate(72, 24, 0);
 	const Pose initialPose = poseCreate(0, 0, 0);
 	odometry = odometryCreate(&encoderWheelL, &encoderWheelR, &encoderWheelM, &xsens, 7.90, initialPose);
+	landmarkCorrector = landmarkCorrectorCreate(&odometry, landmarks,
+			sizeof(landmarks) / sizeof(landmarks[0]), landmarkSensors,
+			sizeof(landmarkSensors) / sizeof(landmarkSensors[0]), 6.0, 2.0, 0.5);
 
 	drive = driveCreate(&motorDriveL, &motorDriveR, &motorDriveL2, &motorDriveR2);
 	const PidController drivePidController = pidControllerCreate(0.15, 0.0, 0.0);
@@ -111,6 +143,17 @@ void initialize() {
 	const PidController turnPidController = pidControllerCreate(3.4, 0, 0.26);
 	navigator = navigatorCreate(&drive, &odometry, drivePidController, straightPidController,
 			turnPidController, 10, 0.5, 0.1, 0);
+	moveLogClear(&moveLog);
+	navigator.moveLog = &moveLog;
+	// The mogo lift is on the front, so only back into a point when it saves a long pivot.
+	navigator.reversePenalty = 400;
+	// Coast models stay zero, with no coast brake, until identifyCoast has been run; set
+	// navigator.driveCoast, navigator.turnCoast and navigator.coastBrakePower here from its output.
+	executive = executiveCreate(executiveJobs, JobCount);
+	mechanismSemaphore = semaphoreCreate();
 
 	liftController = pidControllerCreate(0.01, 0.0, 0.0);
+	intakeTuning = (IntakeTuning) {.maxSpeed = 400.0, .timeConstant = 0.08, .Kp = 0.002,
+			.inSpeed = 360.0, .outSpeed = 400.0, .holdPower = 0.15, .acquiredResidual = 0.5,
+			.jamResidual = 0.7, .confidence = 0.02};
 }
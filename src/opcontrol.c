@@ -15,10 +15,12 @@
 #include "API.h"
 #include "EncoderAnalog.h"
 #include "globals.h"
+#include "MatchPlan.h"
 #include "Motor.h"
 #include "Navigator.h"
 #include "Odometry.h"
 #include "Pose.h"
+#include "Routine.h"
 #include "xsens.h"
 #include "util.h"
 
@@ -32,8 +34,15 @@ PidController normal_right_turn_controller;
 PidController normal_mogo_turn_controller;
 PidController double_mogo_turn_controller;
 
+// Flash file of the routine run by 8-UP, written with 7-RIGHT and tools/routine_asm.py.
+static const char kRoutineFile[] = "auto";
+// Longest 7-RIGHT holds up driver control waiting for a routine, in milliseconds.
+static const unsigned long kRoutineReceiveTimeout = 2000;
+static Routine routine;
+
 void PSC_score_right_wall(double offset)
 {
+	moveLogSetRoutine(&moveLog, "PSC_score_right_wall");
 	// Score Mogo
 	printf("Until left bar");
 
@@ -46,9 +55,9 @@ void PSC_score_right_wall(double offset)
 
 	waitUntilMogo();
 //	mogoUp();
-	navigatorDriveToDistance(&navigator, -5, toRadians(-145+offset), 0.6, 0.2);
-	mogoUp();
-	navigatorDriveToDistance(&navigator, -5, toRadians(-145+offset), 0.6, 0.2);
+	MoveTrigger triggers[] = {moveTriggerDistance(5, mogoUp)};
+	navigatorSetTriggers(&navigator, triggers, 1);
+	navigatorDriveToDistance(&navigator, -10, toRadians(-145+offset), 0.6, 0.2);
 	delay(100);
 	navigator.turnController = normal_turn_controller;
 
@@ -87,6 +96,7 @@ void PSC_loader()
 
 void PSC_first_mogo()
 {
+	moveLogSetRoutine(&moveLog, "PSC_first_mogo");
 	mogoDown();
 	intakeIn();
 	liftMid();
@@ -100,9 +110,9 @@ void PSC_first_mogo()
 
 	navigatorTurnToAngle(&navigator, toRadians(-18), 0.6, -0.1);
 
-	navigatorDriveToDistance(&navigator, -3, toRadians(-18), 0.9, -0.9);
-	liftDown();
-	navigatorDriveToDistance(&navigator, -3, toRadians(-18), 0.9, -0.9);
+	MoveTrigger triggers[] = {moveTriggerDistance(3, liftDown)};
+	navigatorSetTriggers(&navigator, triggers, 1);
+	navigatorDriveToDistance(&navigator, -6, toRadians(-18), 0.9, -0.9);
 	intakeOut();
 	//navigatorDriveToDistance(&navigator, -5, toRadians(-18), 0.9, -0.9);
 	liftLoads();
@@ -141,6 +151,7 @@ void PSC_first_mogo()
 
 void PSC_double_mogo(double offset)
 {
+	moveLogSetRoutine(&moveLog, "PSC_double_mogo");
 	digitalWrite(mogo_tipper_port, LOW);
 	digitalWrite(mogo_release_tipper_port, LOW);
 
@@ -208,6 +219,7 @@ void PSC_double_mogo(double offset)
 
 void PSC_mogo_on_left_wall_single_cone(double offset)
 {
+	moveLogSetRoutine(&moveLog, "PSC_mogo_on_left_wall_single_cone");
 	navigator.turnController = normal_right_turn_controller;
 
 	navigatorTurnToAngle(&navigator, toRadians(135+offset), 0.7, 0.1);
@@ -257,6 +269,7 @@ void PSC_mogo_on_left_wall_single_cone(double offset)
 
 void PSC_mogo_on_left_wall(double offset, int version)
 {
+	moveLogSetRoutine(&moveLog, "PSC_mogo_on_left_wall");
 	navigator.turnController = normal_right_turn_controller;
 
 	navigatorTurnToAngle(&navigator, toRadians(135+offset), 0.7, 0.1);
@@ -320,6 +333,7 @@ void PSC_mogo_on_left_wall(double offset, int version)
 
 void PSC_mogo_on_right_wall(double offset)
 {
+	moveLogSetRoutine(&moveLog, "PSC_mogo_on_right_wall");
 	navigator.turnController = normal_turn_controller;
 
 	// Aligns with lines
@@ -349,6 +363,7 @@ void PSC_mogo_on_right_wall(double offset)
 
 void PSC_right_wall_with_loader(double offset)
 {
+	moveLogSetRoutine(&moveLog, "PSC_right_wall_with_loader");
 	navigator.turnController = normal_turn_controller;
 
 	// Aligns with lines
@@ -388,6 +403,43 @@ void PSC_right_wall_with_loader(double offset)
 
 
 
+void PSC_first_mogo_step(double offset)
+{
+	// PSC_first_mogo has no heading offset.
+	(void) offset;
+	PSC_first_mogo();
+}
+
+/**
+ * Skills run fallback when no routine is saved. Estimates are in ms; values are the points each
+ * routine scores.
+ */
+MatchStep skillsSteps[] = {
+	{.name = "PSC_first_mogo", .run = PSC_first_mogo_step, .estimate = 20000, .value = 10},
+	{.name = "PSC_double_mogo", .run = PSC_double_mogo, .arg = 45, .estimate = 22000,
+			.value = 20},
+	{.name = "PSC_mogo_on_left_wall_single_cone", .run = PSC_mogo_on_left_wall_single_cone,
+			.arg = 180, .estimate = 15000, .value = 10},
+};
+
+/**
+ * Runs the routine saved in flash, using the turn controller indices listed in
+ * tools/routine_asm.py. Returns false if there is no valid routine saved.
+ */
+bool runSavedRoutine()
+{
+	const PidController turnControllers[] = {naive_turn_controller, short_turn_controller,
+			normal_turn_controller, normal_right_turn_controller, normal_mogo_turn_controller,
+			double_mogo_turn_controller};
+
+	if (!routineLoad(&routine, kRoutineFile)) {
+		return false;
+	}
+	moveLogSetRoutine(&moveLog, kRoutineFile);
+	routineRun(&routine, &navigator, 0.0, turnControllers, 6);
+	return true;
+}
+
 /*
  * Runs the user operator control code. This function will be started in its own task with the
  * default priority and stack size whenever the robot is enabled via the Field Management System
@@ -412,13 +464,19 @@ void operatorControl() {
 	int mogo;
 
 	//taskRunLoop(compControlTask, 100);
-	taskRunLoop(odometryTask, 5);
-	//taskRunLoop(debugTask, 100);
-	taskRunLoop(mogoTask, 20);
-
-	taskRunLoop(liftTask, 20);
-	taskRunLoop(intakeTask, 50);
-	taskRunLoop(encoderAnalogTask, 2);
+	executiveStart(&executive);
+	executiveEnable(&executive, JobAnalog, 0);
+	executiveEnable(&executive, JobOdometry, 5);
+	// JobLandmarks stays off until the landmark map and sensor offsets in init.c are measured.
+	executiveEnable(&executive, JobSonar, 0);
+	// Run Navigator loops on every 2nd pose, 10 ms.
+	navigator.controlDivider = 2;
+	//executiveEnable(&executive, JobDebug, 0);
+	executiveEnable(&executive, JobMogo, 0);
+
+	executiveEnable(&executive, JobLift, 0);
+	executiveEnable(&executive, JobIntake, 0);
+	executiveEnable(&executive, JobEncoderAnalog, 0);
 
   	//liftDown();
 	//intakeIn();
@@ -462,14 +520,15 @@ void operatorControl() {
 
 		  if (joystickGetDigital(1, 8, JOY_UP))
 		  {
+			  MatchPlan skills = matchPlanCreate(skillsSteps, 3, MATCH_SKILLS_TIME);
 			  xsens_reset_heading(&xsens, 0, 0, 0);
 			  odometryUseXsens(navigator.odometry);
-			  //liftLoads();
-			  //delay(2000);
-			  //PSC_loader();
-			  PSC_first_mogo();
-			  PSC_double_mogo(45);
-			  PSC_mogo_on_left_wall_single_cone(180);
+			  if (!runSavedRoutine()) {
+				  //liftLoads();
+				  //delay(2000);
+				  //PSC_loader();
+				  matchPlanRun(&skills);
+			  }
 			  //xsens_reset_heading(&xsens, 0, 0, 45);
 			  //odometryUseXsens(navigator.odometry);
 			  //PSC_right_wall_with_loader(180);
@@ -516,6 +575,23 @@ void operatorControl() {
 		}
 		odometryUseXsens(navigator.odometry);
 
+		if (joystickGetDigital(1, 7, JOY_LEFT)) {
+			moveLogDump(&moveLog, stdout);
+			executivePrintStats(&executive, stdout);
+			while (joystickGetDigital(1, 7, JOY_LEFT)) {
+				delay(20);
+			}
+		}
+
+		if (joystickGetDigital(1, 7, JOY_RIGHT)) {
+			// Takes a routine from tools/routine_asm.py --send on the serial link, sent before or
+			// within kRoutineReceiveTimeout of the press.
+			driveSetPowerAll(&drive, 0.0);
+			const bool saved = routineReceive(&routine, stdin, kRoutineFile,
+					kRoutineReceiveTimeout);
+			printf("routine %s\n", saved ? "saved" : "rejected");
+		}
+
 		if (joystickGetDigital(1, 7, JOY_UP)) {
 
 
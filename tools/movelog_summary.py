@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+"""Summarize Navigator move logs dumped over serial.
+
+Reads serial captures containing the "move," CSV lines printed by moveLogDump and prints, for
+every routine leg, how many runs it appeared in and its mean duration, time to threshold, settle
+time, overshoot and exit statuses. Legs are sorted by mean duration so the slowest come first.
+
+Usage: movelog_summary.py capture.txt [capture2.txt ...]
+"""
+
+import collections
+import csv
+import sys
+
+FIELDS = ["move", "routine", "leg", "type", "start", "end", "toThreshold", "settle",
+          "overshoot", "finalError", "status"]
+
+
+def read_moves(paths):
+    for path in paths:
+        with open(path, errors="replace") as f:
+            lines = (line for line in f if line.startswith("move,") and "routine" not in line)
+            for row in csv.DictReader(lines, fieldnames=FIELDS):
+                try:
+                    yield {
+                        "routine": row["routine"],
+                        "leg": int(row["leg"]),
+                        "type": row["type"],
+                        "duration": int(row["end"]) - int(row["start"]),
+                        "toThreshold": int(row["toThreshold"]),
+                        "settle": int(row["settle"]),
+                        "overshoot": float(row["overshoot"]),
+                        "finalError": float(row["finalError"]),
+                        "status": row["status"],
+                    }
+                except (TypeError, ValueError):
+                    continue
+
+
+def mean(values):
+    return sum(values) / len(values) if values else float("nan")
+
+
+def main(paths):
+    legs = collections.defaultdict(list)
+    for move in read_moves(paths):
+        legs[(move["routine"], move["leg"], move["type"])].append(move)
+
+    totals = collections.Counter()
+    rows = []
+    for (routine, leg, kind), moves in legs.items():
+        reached = [m for m in moves if m["toThreshold"] >= 0]
+        duration = mean([m["duration"] for m in moves])
+        totals[routine] += duration
+        statuses = collections.Counter(m["status"] for m in moves)
+        rows.append((duration, routine, leg, kind, len(moves),
+                     mean([m["toThreshold"] for m in reached]),
+                     mean([m["settle"] for m in reached]),
+                     mean([m["overshoot"] for m in moves]),
+                     mean([abs(m["finalError"]) for m in moves]),
+                     " ".join("%s:%d" % item for item in sorted(statuses.items()))))
+
+    print("%-36s %4s %-16s %4s %8s %8s %8s %8s %8s  %s" % (
+        "routine", "leg", "type", "runs", "ms", "thresh", "settle", "oversh", "|error|", "status"))
+    for row in sorted(rows, reverse=True):
+        duration, routine, leg, kind, runs, threshold, settle, overshoot, error, statuses = row
+        print("%-36s %4d %-16s %4d %8.0f %8.0f %8.0f %8.3f %8.3f  %s" % (
+            routine, leg, kind, runs, duration, threshold, settle, overshoot, error, statuses))
+
+    print()
+    for routine, total in totals.most_common():
+        print("%-36s %8.0f ms in moves" % (routine, total))
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        sys.exit(__doc__)
+    main(sys.argv[1:])
@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+"""Assemble autonomous routines into the binary format run by src/Routine.c.
+
+One instruction per line, arguments separated by spaces, '#' starts a comment. Distances are in
+inches, angles in degrees, powers from -1 to 1 and times in ms. Angles of drive and turn
+instructions have the current offset added.
+
+    drive DISTANCE ANGLE MAX_POWER END_POWER
+    drive_until DISTANCE ANGLE MAX_POWER END_POWER CONDITION[|CONDITION...]
+    turn ANGLE MAX_POWER END_POWER
+    drive_to_point X Y MAX_POWER END_POWER
+    turn_to_point X Y MAX_POWER END_POWER
+    drive_for_time LEFT_POWER RIGHT_POWER TIME
+    wait TIME
+    until_target VALUE
+    turn_controller naive|short|normal|normal_right|normal_mogo|double_mogo
+    offset ANGLE
+    mogo up|down|down_slow|hold_up
+    lift up|down|mid|loads|pickup_loads
+    intake in|out|full_in|none
+    wait_mogo
+    wait_lift
+    digital PORT 0|1
+    end
+
+END_POWER of drive_to_point is along the direction of travel, so a negative one brakes whether
+MAX_POWER drives forward or backward.
+
+Conditions are left_line, right_line, back_line, back_sonar, front_left_sonar,
+front_right_sonar, left_bar, right_bar and mogo_found.
+
+Usage: routine_asm.py routine.txt out.bin
+       routine_asm.py routine.txt --send /dev/ttyACM0
+
+--send writes the routine to the serial port; hold 7-RIGHT in operator control first so the
+robot saves it to flash.
+"""
+
+import struct
+import sys
+
+VERSION = 1
+MAX_LENGTH = 1024
+
+DISTANCE = 100.0
+ANGLE = 100.0
+POWER = 1000.0
+
+UNTIL = {
+    "left_line": 0x01, "right_line": 0x02, "back_line": 0x04, "back_sonar": 0x08,
+    "front_left_sonar": 0x10, "front_right_sonar": 0x20, "left_bar": 0x40, "right_bar": 0x80,
+    "mogo_found": 0x100,
+}
+TURN_CONTROLLERS = ["naive", "short", "normal", "normal_right", "normal_mogo", "double_mogo"]
+MOGO = ["up", "down", "down_slow", "hold_up"]
+LIFT = ["up", "down", "mid", "loads", "pickup_loads"]
+INTAKE = ["in", "out", "full_in", "none"]
+
+
+def scaled(scale):
+    return lambda text: round(float(text) * scale)
+
+
+def until(text):
+    mask = 0
+    for name in text.split("|"):
+        mask |= UNTIL[name]
+    return mask
+
+
+def choice(names):
+    return names.index
+
+
+def number(text):
+    return int(text, 0)
+
+
+def milliseconds(text):
+    value = int(text, 0)
+    if not 0 <= value <= 0xFFFF:
+        raise ValueError("time out of range")
+    return value - 0x10000 if value > 0x7FFF else value
+
+
+distance, angle, power = scaled(DISTANCE), scaled(ANGLE), scaled(POWER)
+
+# Opcode and argument parsers, in RoutineOp order.
+OPS = {
+    "end": (0, []),
+    "drive": (1, [distance, angle, power, power]),
+    "drive_until": (2, [distance, angle, power, power, until]),
+    "turn": (3, [angle, power, power]),
+    "drive_to_point": (4, [distance, distance, power, power]),
+    "turn_to_point": (5, [distance, distance, power, power]),
+    "drive_for_time": (6, [power, power, milliseconds]),
+    "wait": (7, [milliseconds]),
+    "until_target": (8, [number]),
+    "turn_controller": (9, [choice(TURN_CONTROLLERS)]),
+    "offset": (10, [angle]),
+    "mogo": (11, [choice(MOGO)]),
+    "lift": (12, [choice(LIFT)]),
+    "intake": (13, [choice(INTAKE)]),
+    "wait_mogo": (14, []),
+    "wait_lift": (15, []),
+    "digital": (16, [number, number]),
+}
+
+
+def assemble(lines):
+    code = bytearray()
+    for line_number, line in enumerate(lines, 1):
+        words = line.split("#", 1)[0].split()
+        if not words:
+            continue
+        try:
+            opcode, parsers = OPS[words[0]]
+            if len(words) - 1 != len(parsers):
+                raise ValueError("expected %d arguments" % len(parsers))
+            code.append(opcode)
+            for parse, text in zip(parsers, words[1:]):
+                code += struct.pack("<h", parse(text))
+        except (KeyError, ValueError, struct.error) as e:
+            sys.exit("line %d: %s: %s" % (line_number, line.strip(), e))
+    if len(code) > MAX_LENGTH:
+        sys.exit("routine is %d bytes, at most %d fit" % (len(code), MAX_LENGTH))
+    return b"RT" + bytes([VERSION, 0]) + struct.pack("<H", len(code)) + code
+
+
+def main(args):
+    if len(args) != 2 and not (len(args) == 3 and args[1] == "--send"):
+        sys.exit(__doc__)
+    with open(args[0]) as f:
+        routine = assemble(f)
+    with open(args[-1], "wb") as out:
+        out.write(routine)
+    print("%d bytes" % len(routine))
+
+
+if __name__ == "__main__":
+    main(sys.argv[1:])